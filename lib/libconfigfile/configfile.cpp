@@ -31,6 +31,7 @@
 #include <cstdlib>
 #include <cerrno>
 #include <cstring>
+#include <cstdio>
 
 #include <sys/stat.h>
 #include <unistd.h>
@@ -52,32 +53,51 @@ void CConfigFile::clear()
 //
 // public file operation methods
 //
+static bool readFile(const char *const filename, std::string &data)
+{
+	int fd = ::open(filename, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+		data.reserve(st.st_size);
+
+	char buf[16384];
+	ssize_t len;
+	while ((len = ::read(fd, buf, sizeof(buf))) > 0)
+		data.append(buf, len);
+	::close(fd);
+	return len == 0;
+}
+
 bool CConfigFile::loadConfig(const char *const filename, char _delimiter)
 {
-	std::ifstream configFile(filename);
+	std::string data;
 
-	if (configFile.good())
+	if (readFile(filename, data))
 	{
-		std::string s;
 		clear();
 		modifiedFlag = false;
 
-		for (int linenr = 1; ; linenr++)
+		/* whole file in one read, split lines in place */
+		std::string::size_type pos = 0;
+		while (pos < data.length())
 		{
-			getline(configFile, s);
-			if (configFile.fail())
-				break;
+			std::string::size_type eol = data.find('\n', pos);
+			if (eol == std::string::npos)
+				eol = data.length();
 
-			std::string::size_type i = s.find(_delimiter);
-			if (i != std::string::npos)
+			std::string::size_type i = data.find(_delimiter, pos);
+			if (i < eol)
 			{
-				std::string::size_type j = s.find('#');
-				if (j == std::string::npos)
-					j = s.length();
-				configData[s.substr(0, i)] = s.substr(i + 1, j - (i + 1));
+				std::string::size_type j = data.find('#', pos);
+				if (j > eol || j < i)
+					j = eol;
+				configData[data.substr(pos, i - pos)] = data.substr(i + 1, j - (i + 1));
 			}
+			pos = eol + 1;
 		}
-		configFile.close();
 		return true;
 	}
 	else
@@ -94,26 +114,52 @@ bool CConfigFile::loadConfig(const std::string &filename, char _delimiter)
 
 bool CConfigFile::saveConfig(const char *const filename, char _delimiter)
 {
+	std::string data;
+	for (ConfigDataMap::const_iterator it = configData.begin(); it != configData.end(); ++it)
+	{
+		data.reserve(data.length() + it->first.length() + it->second.length() + 2);
+		data += it->first;
+		data += _delimiter;
+		data += it->second;
+		data += '\n';
+	}
+
+	/* nothing changed on disk, save the write and fdatasync to flash */
+	std::string old;
+	if (readFile(filename, old) && old == data)
+	{
+		modifiedFlag = false;
+		return true;
+	}
+
 	std::string tmpname = std::string(filename) + ".tmp";
 	unlink(tmpname.c_str());
-	std::fstream configFile(tmpname.c_str(), std::ios::out);
+	int fd = ::open(tmpname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
 
-	if (configFile.good())
+	if (fd >= 0)
 	{
 		std::cout << "[ConfigFile] saving " << filename << std::endl;
-		for (ConfigDataMap::const_iterator it = configData.begin(); it != configData.end(); ++it)
+		const char *p = data.c_str();
+		size_t left = data.length();
+		while (left > 0)
 		{
-			configFile << it->first << _delimiter << it->second << std::endl;
+			ssize_t done = ::write(fd, p, left);
+			if (done < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				break;
+			}
+			p += done;
+			left -= done;
 		}
-
-		configFile.flush();
-		configFile.close();
+		bool ok = (left == 0) && (::fdatasync(fd) == 0 || errno == EINVAL);
+		ok = (::close(fd) == 0) && ok;
+		if (!ok)
 		{
-			int syncfd = ::open(tmpname.c_str(), O_RDWR);
-			if (syncfd >= 0) {
-				::fdatasync(syncfd);
-				::close(syncfd);
-			}
+			std::cerr << "[ConfigFile] Unable to write " << tmpname << ": " << strerror(errno) << std::endl;
+			unlink(tmpname.c_str());
+			return false;
 		}
 
 		chmod(tmpname.c_str(), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
@@ -150,16 +196,16 @@ void CConfigFile::storeBool(const std::string &key, const bool val)
 
 void CConfigFile::storeInt32(const std::string &key, const int32_t val)
 {
-	std::stringstream s;
-	s << val;
-	s >> configData[key];
+	char buf[16];
+	snprintf(buf, sizeof(buf), "%d", val);
+	configData[key] = buf;
 }
 
 void CConfigFile::storeInt64(const std::string &key, const int64_t val)
 {
-	std::stringstream s;
-	s << val;
-	s >> configData[key];
+	char buf[24];
+	snprintf(buf, sizeof(buf), "%lld", (long long)val);
+	configData[key] = buf;
 }
 
 void CConfigFile::storeString(const std::string &key, const std::string &val)
@@ -167,6 +213,18 @@ void CConfigFile::storeString(const std::string &key, const std::string &val)
 	configData[key] = val;
 }
 
+/* one map lookup per get, the default is stored if wanted */
+const std::string *CConfigFile::lookup(const std::string &key)
+{
+	ConfigDataMap::const_iterator it = configData.find(key);
+	if (it != configData.end())
+		return &it->second;
+
+	if (saveDefaults)
+		unknownKeyQueryedFlag = true;
+	return NULL;
+}
+
 
 
 //
@@ -179,20 +237,15 @@ bool CConfigFile::getBool(const char *const key, const bool defaultVal)
 
 bool CConfigFile::getBool(const std::string &key, const bool defaultVal)
 {
-	if (configData.find(key) == configData.end())
+	const std::string *val = lookup(key);
+	if (!val)
 	{
 		if (saveDefaults)
-		{
-			unknownKeyQueryedFlag = true;
 			storeBool(key, defaultVal);
-		}
-		else
-		{
-			return defaultVal;
-		}
+		return defaultVal;
 	}
 
-	return !((configData[key] == "false") || (configData[key] == "0"));
+	return !((*val == "false") || (*val == "0"));
 }
 
 int32_t CConfigFile::getInt32(const char *const key, const int32_t defaultVal)
@@ -202,24 +255,19 @@ int32_t CConfigFile::getInt32(const char *const key, const int32_t defaultVal)
 
 int32_t CConfigFile::getInt32(const std::string &key, const int32_t defaultVal)
 {
-	if (configData.find(key) == configData.end())
+	const std::string *val = lookup(key);
+	if (!val)
 	{
 		if (saveDefaults)
-		{
-			unknownKeyQueryedFlag = true;
 			storeInt32(key, defaultVal);
-		}
-		else
-		{
-			return defaultVal;
-		}
+		return defaultVal;
 	}
 
-	if (configData[key] == "false")
+	if (*val == "false")
 		return 0;
-	if (configData[key] == "true")
+	if (*val == "true")
 		return 1;
-	return atoi(configData[key].c_str());
+	return atoi(val->c_str());
 }
 
 int64_t CConfigFile::getInt64(const char *const key, const int64_t defaultVal)
@@ -229,24 +277,19 @@ int64_t CConfigFile::getInt64(const char *const key, const int64_t defaultVal)
 
 int64_t CConfigFile::getInt64(const std::string &key, const int64_t defaultVal)
 {
-	if (configData.find(key) == configData.end())
+	const std::string *val = lookup(key);
+	if (!val)
 	{
 		if (saveDefaults)
-		{
-			unknownKeyQueryedFlag = true;
 			storeInt64(key, defaultVal);
-		}
-		else
-		{
-			return defaultVal;
-		}
+		return defaultVal;
 	}
 
-	if (configData[key] == "false")
+	if (*val == "false")
 		return 0;
-	if (configData[key] == "true")
+	if (*val == "true")
 		return 1;
-	return atoll(configData[key].c_str());
+	return atoll(val->c_str());
 }
 
 std::string CConfigFile::getString(const char *const key, const std::string &defaultVal)
@@ -256,20 +299,15 @@ std::string CConfigFile::getString(const char *const key, const std::string &def
 
 std::string CConfigFile::getString(const std::string &key, const std::string &defaultVal)
 {
-	if (configData.find(key) == configData.end())
+	const std::string *val = lookup(key);
+	if (!val)
 	{
 		if (saveDefaults)
-		{
-			unknownKeyQueryedFlag = true;
 			storeString(key, defaultVal);
-		}
-		else
-		{
-			return defaultVal;
-		}
+		return defaultVal;
 	}
 
-	return configData[key];
+	return *val;
 }
 
 std::vector <int32_t> CConfigFile::getInt32Vector(const std::string &key)
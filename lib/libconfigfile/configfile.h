@@ -46,6 +46,7 @@ class CConfigFile
 		void storeInt32(const std::string &key, const int32_t val);
 		void storeInt64(const std::string &key, const int64_t val);
 		void storeString(const std::string &key, const std::string &val);
+		const std::string *lookup(const std::string &key);
 
 	public:
 		CConfigFile(const char p_delimiter, const bool p_saveDefaults = true);
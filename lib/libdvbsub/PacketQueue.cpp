@@ -1,47 +1,78 @@
 #include <cstdlib>
-#include <pthread.h>
-#include <list>
+#include <cstring>
 #include "Debug.hpp"
 #include "PacketQueue.hpp"
 
 PacketQueue::PacketQueue()
 {
-	pthread_mutex_init(&mutex, NULL);
+	memset(slots, 0, sizeof(slots));
+	head = 0;
+	tail = 0;
+	flush_pos = 0;
+	flush_req = false;
 }
 
 PacketQueue::~PacketQueue()
 {
-	while (queue.begin() != queue.end()) {
-		delete[] queue.front();
-		queue.pop_front();
-	}
+	for (int i = 0; i < PACKET_QUEUE_SLOTS; i++)
+		free(slots[i].data);
 }
 
-void PacketQueue::push(uint8_t* data)
+uint8_t* PacketQueue::reserve(size_t len)
 {
-	pthread_mutex_lock(&mutex);
+	unsigned int h = head.load(std::memory_order_relaxed);
+	if (h - tail.load(std::memory_order_acquire) >= PACKET_QUEUE_SLOTS)
+		return NULL;
 
-	queue.push_back(data);
+	slot &s = slots[h % PACKET_QUEUE_SLOTS];
+	if (s.size < len) {
+		free(s.data);
+		s.data = (uint8_t*) malloc(len);
+		s.size = s.data ? len : 0;
+	}
+	return s.data;
+}
 
-	pthread_mutex_unlock(&mutex);
+void PacketQueue::push()
+{
+	head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
 }
 
-uint8_t* PacketQueue::pop()
+void PacketQueue::flush()
 {
-	uint8_t* retval;
+	flush_pos.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	flush_req.store(true, std::memory_order_release);
+}
 
-	pthread_mutex_lock(&mutex);
+void PacketQueue::consumer_flush()
+{
+	flush_req.store(false, std::memory_order_relaxed);
+	tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+}
 
-	retval = queue.front();
-	queue.pop_front();
+uint8_t* PacketQueue::front()
+{
+	unsigned int t = tail.load(std::memory_order_relaxed);
+	if (flush_req.exchange(false, std::memory_order_acquire)) {
+		unsigned int f = flush_pos.load(std::memory_order_relaxed);
+		/* never move back behind a consumer_flush() */
+		if ((int)(f - t) > 0) {
+			t = f;
+			tail.store(t, std::memory_order_release);
+		}
+	}
 
-	pthread_mutex_unlock(&mutex);
-	
-	return retval;
+	if (t == head.load(std::memory_order_acquire))
+		return NULL;
+	return slots[t % PACKET_QUEUE_SLOTS].data;
 }
 
-size_t PacketQueue::size()
+void PacketQueue::pop()
 {
-	return queue.size();
+	tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
 }
 
+size_t PacketQueue::size()
+{
+	return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+}
@@ -1,20 +1,42 @@
 #ifndef PACKET_QUEUE_H_
 #define PACKET_QUEUE_H_
 #include <inttypes.h>
-#include <pthread.h>
-#include <list>
+#include <stddef.h>
+#include <atomic>
+
+/* bounded single producer / single consumer ring of PES buffers.
+ * slot buffers are kept and only grown, so there is no allocation per
+ * packet once the biggest packets have been seen. */
+#define PACKET_QUEUE_SLOTS 64
 
 class PacketQueue {
 public:
 	PacketQueue();
 	~PacketQueue();
-	void push(uint8_t* data);
-	uint8_t* pop();
+	/* producer: buffer for a packet of len bytes, NULL if full */
+	uint8_t* reserve(size_t len);
+	/* producer: publish the reserved buffer */
+	void push();
+	/* producer: drop everything pushed so far, applied by the
+	 * consumer on its next front() */
+	void flush();
+	/* consumer: drop everything pushed so far, right now */
+	void consumer_flush();
+	/* consumer: oldest packet or NULL, stays valid until pop() */
+	uint8_t* front();
+	void pop();
 	size_t size();
 
 private:
-	std::list<uint8_t*> queue;
-	pthread_mutex_t mutex;
+	struct slot {
+		uint8_t *data;
+		size_t size;
+	};
+	slot slots[PACKET_QUEUE_SLOTS];
+	std::atomic<unsigned int> head;
+	std::atomic<unsigned int> tail;
+	std::atomic<unsigned int> flush_pos;
+	std::atomic<bool> flush_req;
 };
 
 #endif
@@ -142,8 +142,7 @@ void dvbsub_setpid(int pid)
 	if(dvbsub_pid == 0)
 		return;
 
-	clear_queue();
-
+	/* the reader drops the queue when it picks up pid_change_req */
 	if(dvbSubtitleConverter)
 		dvbSubtitleConverter->Reset();
 
@@ -223,14 +222,7 @@ static int64_t get_pts_stc_delta(int64_t pts)
 
 static void clear_queue()
 {
-	uint8_t* packet;
-
-	pthread_mutex_lock(&packetMutex);
-	while(packet_queue.size()) {
-		packet = packet_queue.pop();
-		free(packet);
-	}
-	pthread_mutex_unlock(&packetMutex);
+	packet_queue.flush();
 }
 
 static void* reader_thread(void * /*arg*/)
@@ -240,6 +232,8 @@ static void* reader_thread(void * /*arg*/)
 	int len;
 	uint16_t packlen;
 	uint8_t* buf;
+	/* packets are read to here and dropped when the queue is full */
+	static uint8_t discard[0xffff + 6];
 	bool bad_startcode = false;
 	set_threadname("dvbsub:reader");
 
@@ -291,7 +285,11 @@ static void* reader_thread(void * /*arg*/)
 
 		packlen =  getbits(tmp, 4*8, 16) + 6;
 
-		buf = (uint8_t*) malloc(packlen);
+		buf = packet_queue.reserve(packlen);
+		if (!buf) {
+			sub_debug.print(Debug::INFO, "[subtitles] queue full, dropping packet\n");
+			buf = discard;
+		}
 
 		memmove(buf, tmp, 6);
 		/* read rest of the packet */
@@ -304,18 +302,14 @@ static void* reader_thread(void * /*arg*/)
 			}
 		}
 
-		if(!dvbsub_stopped /*!dvbsub_paused*/) {
+		if(!dvbsub_stopped /*!dvbsub_paused*/ && buf != discard) {
 			sub_debug.print(Debug::VERBOSE, "[subtitles] *** new packet, len %d buf 0x%x pts-stc diff %lld ***\n", count, buf, get_pts_stc_delta(get_pts(buf)));
 			/* Packet now in memory */
-			packet_queue.push(buf);
-			/* TODO: allocation exception */
+			packet_queue.push();
 			// wake up dvb thread
 			pthread_mutex_lock(&packetMutex);
 			pthread_cond_broadcast(&packetCond);
 			pthread_mutex_unlock(&packetMutex);
-		} else {
-			free(buf);
-			buf=NULL;
 		}
 	}
 
@@ -354,56 +348,47 @@ static void* dvbsub_thread(void* /*arg*/)
 		restartWait.tv_nsec = now.tv_usec * 1000; // nano seconds
 
 		pthread_mutex_lock( &packetMutex );
-		pthread_cond_timedwait( &packetCond, &packetMutex, &restartWait );
+		/* the reader signals under packetMutex, so no wakeup is lost */
+		if (packet_queue.size() == 0)
+			pthread_cond_timedwait( &packetCond, &packetMutex, &restartWait );
 		pthread_mutex_unlock( &packetMutex );
 
-		timeout = dvbSubtitleConverter->Action();
-
-		if(packet_queue.size() == 0) {
-			continue;
-		}
-		sub_debug.print(Debug::VERBOSE, "PES: Wakeup, queue size %d\n", packet_queue.size());
 		if(dvbsub_stopped /*dvbsub_paused*/) {
-			clear_queue();
+			packet_queue.consumer_flush();
+			timeout = dvbSubtitleConverter->Action();
 			continue;
 		}
-		pthread_mutex_lock(&packetMutex);
-		packet = packet_queue.pop();
-		pthread_mutex_unlock(&packetMutex);
+		if (packet_queue.size())
+			sub_debug.print(Debug::VERBOSE, "PES: Wakeup, queue size %d\n", packet_queue.size());
 
-		if (!packet) {
-			sub_debug.print(Debug::VERBOSE, "Error no packet found\n");
-			continue;
-		}
-		packlen = (packet[4] << 8 | packet[5]) + 6;
+		/* decode everything queued, display is scheduled by Action() */
+		while ((packet = packet_queue.front()) != NULL) {
+			packlen = (packet[4] << 8 | packet[5]) + 6;
 
-		pts = get_pts(packet);
+			pts = get_pts(packet);
 
-		dataoffset = packet[8] + 8 + 1;
-		if (packet[dataoffset] != 0x20) {
-			sub_debug.print(Debug::VERBOSE, "Not a dvb subtitle packet, discard it (len %d)\n", packlen);
-			goto next_round;
-		}
-
-		sub_debug.print(Debug::VERBOSE, "PES packet: len %d data len %d PTS=%Ld (%02d:%02d:%02d.%d) diff %lld\n",
-				packlen, packlen - (dataoffset + 2), pts, (int)(pts/324000000), (int)((pts/5400000)%60),
-				(int)((pts/90000)%60), (int)(pts%90000), get_pts_stc_delta(pts));
+			dataoffset = packet[8] + 8 + 1;
+			if (packet[dataoffset] != 0x20) {
+				sub_debug.print(Debug::VERBOSE, "Not a dvb subtitle packet, discard it (len %d)\n", packlen);
+				packet_queue.pop();
+				continue;
+			}
 
-		if (packlen <= dataoffset + 3) {
-			sub_debug.print(Debug::INFO, "Packet too short, discard\n");
-			goto next_round;
-		}
+			sub_debug.print(Debug::VERBOSE, "PES packet: len %d data len %d PTS=%Ld (%02d:%02d:%02d.%d) diff %lld\n",
+					packlen, packlen - (dataoffset + 2), pts, (int)(pts/324000000), (int)((pts/5400000)%60),
+					(int)((pts/90000)%60), (int)(pts%90000), get_pts_stc_delta(pts));
 
-		if (packet[dataoffset + 2] == 0x0f) {
-			dvbSubtitleConverter->Convert(&packet[dataoffset + 2],
-					packlen - (dataoffset + 2), pts);
-		} else {
-			sub_debug.print(Debug::INFO, "End_of_PES is missing\n");
+			if (packlen <= dataoffset + 3) {
+				sub_debug.print(Debug::INFO, "Packet too short, discard\n");
+			} else if (packet[dataoffset + 2] == 0x0f) {
+				dvbSubtitleConverter->Convert(&packet[dataoffset + 2],
+						packlen - (dataoffset + 2), pts);
+			} else {
+				sub_debug.print(Debug::INFO, "End_of_PES is missing\n");
+			}
+			packet_queue.pop();
 		}
 		timeout = dvbSubtitleConverter->Action();
-
-next_round:
-		free(packet);
 	}
 
 	delete dvbSubtitleConverter;
@@ -24,6 +24,7 @@ extern "C" {
 #include <pthread.h>
 }
 #include <driver/framebuffer.h>
+#include <vector>
 #include "Debug.hpp"
 
 #if LIBAVCODEC_VERSION_INT <= AV_VERSION_INT(57, 1, 99)
@@ -37,16 +38,27 @@ static bool DebugConverter = true;
 
 #define dbgconverter(a...) if (DebugConverter) sub_debug.print(Debug::VERBOSE, a)
 
+/* rect scaled to screen size when decoded, so showing it is only a blit */
+struct cScaledRect
+{
+	fb_pixel_t *data;
+	int x, y, w, h;
+};
+
 class cDvbSubtitleBitmaps : public cListObject 
 {
 	private:
 		int64_t pts;
 		AVSubtitle sub;
+		std::vector<cScaledRect> scaled;
+		int scaled_w, scaled_h;
+		void FreeScaled(void);
 	public:
 		cDvbSubtitleBitmaps(int64_t Pts);
 		~cDvbSubtitleBitmaps();
 		int64_t Pts(void) { return pts; }
 		int Timeout(void) { return sub.end_display_time; }
+		void Scale(void);
 		void Draw(int &min_x, int &min_y, int &max_x, int &max_y);
 		int Count(void) { return sub.num_rects; };
 		AVSubtitle * GetSub(void) { return &sub; };
@@ -56,6 +68,7 @@ cDvbSubtitleBitmaps::cDvbSubtitleBitmaps(int64_t pPts)
 {
 	//dbgconverter("cDvbSubtitleBitmaps::new: PTS: %lld\n", pts);
 	pts = pPts;
+	scaled_w = scaled_h = 0;
 }
 
 cDvbSubtitleBitmaps::~cDvbSubtitleBitmaps()
@@ -63,6 +76,7 @@ cDvbSubtitleBitmaps::~cDvbSubtitleBitmaps()
     dbgconverter("cDvbSubtitleBitmaps::delete: PTS: %lld rects %d\n", pts, Count());
     int i;
 
+    FreeScaled();
     if(sub.rects) {
 	    for (i = 0; i < Count(); i++)
 	    {
@@ -81,42 +95,60 @@ cDvbSubtitleBitmaps::~cDvbSubtitleBitmaps()
     memset(&sub, 0, sizeof(AVSubtitle));
 }
 
-fb_pixel_t * simple_resize32(uint8_t * orgin, uint32_t * colors, int nb_colors, int ox, int oy, int dx, int dy)
+static void resize_rect32(fb_pixel_t *dst, uint8_t * orgin, uint32_t * colors, int nb_colors, int ox, int oy, int dx, int dy)
 {
-	fb_pixel_t  *cr,*l;
-	int i,j,k,ip;
-
-	cr = CFrameBuffer::getInstance()->getBackBufferPointer();
-	l = cr;
+	fb_pixel_t *l = dst;
+	int i,j,ip;
 
 	for(j = 0; j < dy; j++, l += dx)
 	{
 		uint8_t * p = orgin + (j*oy/dy*ox);
-		for(i = 0, k = 0; i < dx; i++, k++) {
+		for(i = 0; i < dx; i++) {
 			ip = i*ox/dx;
 			int idx = p[ip];
 			if(idx < nb_colors)
-				l[k] = colors[idx];
+				l[i] = colors[idx];
 		}
 	}
+}
+
+fb_pixel_t * simple_resize32(uint8_t * orgin, uint32_t * colors, int nb_colors, int ox, int oy, int dx, int dy)
+{
+	fb_pixel_t *cr = CFrameBuffer::getInstance()->getBackBufferPointer();
+	resize_rect32(cr, orgin, colors, nb_colors, ox, oy, dx, dy);
 	return(cr);
 }
 
-void cDvbSubtitleBitmaps::Draw(int &min_x, int &min_y, int &max_x, int &max_y)
+void cDvbSubtitleBitmaps::FreeScaled(void)
+{
+	for (unsigned i = 0; i < scaled.size(); i++)
+		free(scaled[i].data);
+	scaled.clear();
+}
+
+void cDvbSubtitleBitmaps::Scale(void)
 {
 	int i;
 	int sw = CFrameBuffer::getInstance()->getScreenWidth(true);
 	int sh = CFrameBuffer::getInstance()->getScreenHeight(true);
 
+	if (sw == scaled_w && sh == scaled_h && (int) scaled.size() == Count())
+		return;
+	FreeScaled();
+	scaled_w = sw;
+	scaled_h = sh;
+
 	for (i = 0; i < Count(); i++) {
 #if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57, 5, 0)
 		uint32_t * colors = (uint32_t *) sub.rects[i]->pict.data[1];
+		uint8_t * data = sub.rects[i]->pict.data[0];
 #else
 		uint32_t * colors = (uint32_t *) sub.rects[i]->data[1];
+		uint8_t * data = sub.rects[i]->data[0];
 #endif
 		int width = sub.rects[i]->w;
 		int height = sub.rects[i]->h;
-		int xoff, yoff;
+		cScaledRect r;
 
 		int h2 = 576;
 		switch (width)
@@ -125,30 +157,40 @@ void cDvbSubtitleBitmaps::Draw(int &min_x, int &min_y, int &max_x, int &max_y)
 			case 1920:	h2 = 1080; break;
 		}
 
-		xoff = sub.rects[i]->x * sw / width;
-		yoff = sub.rects[i]->y * sh / h2;
-		int nw = width * sw / width;
-		int nh = height * sh / h2;
+		r.x = sub.rects[i]->x * sw / width;
+		r.y = sub.rects[i]->y * sh / h2;
+		r.w = width * sw / width;
+		r.h = height * sh / h2;
 
-		dbgconverter("cDvbSubtitleBitmaps::Draw: #%d at %d,%d size %dx%d colors %d (x=%d y=%d w=%d h=%d) \n", i+1, 
-				sub.rects[i]->x, sub.rects[i]->y, sub.rects[i]->w, sub.rects[i]->h, sub.rects[i]->nb_colors, xoff, yoff, nw, nh);
+		dbgconverter("cDvbSubtitleBitmaps::Scale: #%d at %d,%d size %dx%d colors %d (x=%d y=%d w=%d h=%d) \n", i+1,
+				sub.rects[i]->x, sub.rects[i]->y, sub.rects[i]->w, sub.rects[i]->h, sub.rects[i]->nb_colors, r.x, r.y, r.w, r.h);
 
-#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57, 5, 0)
-		fb_pixel_t * newdata = simple_resize32 (sub.rects[i]->pict.data[0], colors, sub.rects[i]->nb_colors, width, height, nw, nh);
-#else
-		fb_pixel_t * newdata = simple_resize32 (sub.rects[i]->data[0], colors, sub.rects[i]->nb_colors, width, height, nw, nh);
-#endif
-
-		CFrameBuffer::getInstance()->blit2FB(newdata, nw, nh, xoff, yoff, 0, 0, true);
+		r.data = (fb_pixel_t *) calloc(r.w * r.h, sizeof(fb_pixel_t));
+		if (!r.data)
+			continue;
+		resize_rect32(r.data, data, colors, sub.rects[i]->nb_colors, width, height, r.w, r.h);
+		scaled.push_back(r);
+	}
+}
 
-		if(min_x > xoff)
-			min_x = xoff;
-		if(min_y > yoff)
-			min_y = yoff;
-		if(max_x < (xoff + nw))
-			max_x = xoff + nw;
-		if(max_y < (yoff + nh))
-			max_y = yoff + nh;
+void cDvbSubtitleBitmaps::Draw(int &min_x, int &min_y, int &max_x, int &max_y)
+{
+	/* normally done in Convert(), again only if the screen size changed */
+	Scale();
+
+	for (unsigned i = 0; i < scaled.size(); i++) {
+		cScaledRect &r = scaled[i];
+
+		CFrameBuffer::getInstance()->blit2FB(r.data, r.w, r.h, r.x, r.y, 0, 0, true);
+
+		if(min_x > r.x)
+			min_x = r.x;
+		if(min_y > r.y)
+			min_y = r.y;
+		if(max_x < (r.x + r.w))
+			max_x = r.x + r.w;
+		if(max_y < (r.y + r.h))
+			max_y = r.y + r.h;
 	}
 
 	if(Count())
@@ -304,6 +346,8 @@ int cDvbSubtitleConverter::Convert(const uchar *Data, int Length, int64_t pts)
 						sub->rects[i]->x, sub->rects[i]->y, sub->rects[i]->w, sub->rects[i]->h, sub->rects[i]->nb_colors);
 			}
 		}
+		/* scale now, Action() only has to blit when the PTS is due */
+		Bitmaps->Scale();
 		bitmaps->Add(Bitmaps);
 		Bitmaps = NULL;
 	}
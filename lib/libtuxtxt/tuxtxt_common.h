@@ -17,6 +17,65 @@
 tuxtxt_cache_struct tuxtxt_cache;
 static pthread_mutex_t tuxtxt_cache_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t tuxtxt_cache_biglock = PTHREAD_MUTEX_INITIALIZER;
+/* page data of magazine 1-8 (page 0x100-0x8ff), so the cache thread and
+ * the renderer only block each other when working on the same magazine */
+static pthread_mutex_t tuxtxt_page_lock[9] = {
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER
+};
+#define TUXTXT_PAGE_LOCK(p)	(&tuxtxt_page_lock[((p) >> 8) % 9])
+
+/* cached pages are taken from slabs and put back on clear_cache, together
+ * with their data buffer, so a channel change does not malloc every page again */
+#define TUXTXT_PAGE_SLAB 64
+static tstCachedPage *tuxtxt_page_pool = NULL;
+
+/* called with tuxtxt_cache_lock held */
+static tstCachedPage *tuxtxt_page_alloc(void)
+{
+	if (!tuxtxt_page_pool)
+	{
+		tstCachedPage *slab = (tstCachedPage*) calloc(TUXTXT_PAGE_SLAB, sizeof(tstCachedPage));
+		if (!slab)
+			return NULL;
+		for (int i = 0; i < TUXTXT_PAGE_SLAB; i++)
+		{
+			/* free pages are linked through pageinfo */
+			*(tstCachedPage **) &slab[i].pageinfo = tuxtxt_page_pool;
+			tuxtxt_page_pool = &slab[i];
+		}
+	}
+	tstCachedPage *pg = tuxtxt_page_pool;
+	tuxtxt_page_pool = *(tstCachedPage **) &pg->pageinfo;
+	return pg;
+}
+
+static void tuxtxt_page_free(tstCachedPage *pg)
+{
+	*(tstCachedPage **) &pg->pageinfo = tuxtxt_page_pool;
+	tuxtxt_page_pool = pg;
+}
+
+#if TUXTXT_COMPRESS > 0
+/* grow page buffer if needed, called with page lock held */
+static bool tuxtxt_page_reserve(tstCachedPage *pg, int len)
+{
+	if (pg->pData && pg->zipcap >= len)
+		return true;
+	if (pg->pData)
+		free(pg->pData);//realloc(pg->pData,j); realloc scheint nicht richtig zu funktionieren?
+	/* round up, the size of a page changes a little with every update */
+	pg->zipcap = (len + 63) & ~63;
+	if (pg->zipcap > 23*40)
+		pg->zipcap = 23*40;
+	pg->pData = (unsigned char*)malloc(pg->zipcap);
+	if (!pg->pData)
+		pg->zipcap = 0;
+	return pg->pData != NULL;
+}
+#endif
+
 int tuxtxt_get_zipsize(int p,int sp)
 {
     tstCachedPage* pg = tuxtxt_cache.astCachetable[p][sp];
@@ -24,15 +83,7 @@ int tuxtxt_get_zipsize(int p,int sp)
 #if TUXTXT_COMPRESS == 1
 	return pg->ziplen;
 #elif TUXTXT_COMPRESS == 2
-	pthread_mutex_lock(&tuxtxt_cache_lock);
-	int zipsize = 0,i,j;
-	for (i = 0; i < 23*5; i++)
-		for (j = 0; j < 8; j++)
-		zipsize += pg->bitmask[i]>>j & 0x01;
-
-	zipsize+=23*5;//bitmask
-	pthread_mutex_unlock(&tuxtxt_cache_lock);
-	return zipsize;
+	return pg->ziplen + 23*5;//bitmask
 #else
 	return 23*40;
 #endif
@@ -42,12 +93,12 @@ void tuxtxt_compress_page(int p, int sp, unsigned char* buffer)
 	if (!tuxtxt_cache.receiving) {
 		return;
 	}
-	pthread_mutex_lock(&tuxtxt_cache_lock);
+	pthread_mutex_lock(TUXTXT_PAGE_LOCK(p));
 	tstCachedPage* pg = tuxtxt_cache.astCachetable[p][sp];
 	if (!pg)
 	{
 		printf("tuxtxt: trying to compress a not allocated page!!\n");
-		pthread_mutex_unlock(&tuxtxt_cache_lock);
+		pthread_mutex_unlock(TUXTXT_PAGE_LOCK(p));
 		return;
 	}
 
@@ -56,10 +107,8 @@ void tuxtxt_compress_page(int p, int sp, unsigned char* buffer)
 	uLongf comprlen = 23*40;
 	if (compress2(pagecompressed,&comprlen,buffer,23*40,Z_BEST_SPEED) == Z_OK)
 	{
-		if (pg->pData) free(pg->pData);//realloc(pg->pData,j); realloc scheint nicht richtig zu funktionieren?
-		pg->pData = malloc(comprlen);
 		pg->ziplen = 0;
-		if (pg->pData)
+		if (tuxtxt_page_reserve(pg, comprlen))
 		{
 			pg->ziplen = comprlen;
 			memmove(pg->pData,pagecompressed,comprlen);
@@ -76,20 +125,21 @@ void tuxtxt_compress_page(int p, int sp, unsigned char* buffer)
 		pg->bitmask[i>>3] |= 0x80>>(i&0x07);
 		cbuf[j++]=buffer[i];
 	}
-	if (pg->pData)
-		free(pg->pData);//realloc(pg->pData,j); realloc scheint nicht richtig zu funktionieren?
-	pg->pData = (unsigned char*)malloc(j);
-	if (pg->pData)
+	if (tuxtxt_page_reserve(pg, j))
 	{
 		memmove(pg->pData,cbuf,j);
+		pg->ziplen = j;
 	}
 	else
+	{
 		memset(pg->bitmask,0,sizeof(pg->bitmask));
+		pg->ziplen = 0;
+	}
 #else
 	//if (pg->pData)
 		memmove(pg->data,buffer,23*40);
 #endif
-	pthread_mutex_unlock(&tuxtxt_cache_lock);
+	pthread_mutex_unlock(TUXTXT_PAGE_LOCK(p));
 }
 
 void tuxtxt_decompress_page(int p, int sp, unsigned char* buffer)
@@ -98,14 +148,14 @@ void tuxtxt_decompress_page(int p, int sp, unsigned char* buffer)
 		memset(buffer,' ',23*40);
 		return;
 	}
-	pthread_mutex_lock(&tuxtxt_cache_lock);
+	pthread_mutex_lock(TUXTXT_PAGE_LOCK(p));
 	tstCachedPage* pg = tuxtxt_cache.astCachetable[p][sp];
 
 	memset(buffer,' ',23*40);
 	if (!pg)
 	{
 		printf("tuxtxt: trying to decompress a not allocated page!!\n");
-		pthread_mutex_unlock(&tuxtxt_cache_lock);
+		pthread_mutex_unlock(TUXTXT_PAGE_LOCK(p));
 		return;
 	}
 #if TUXTXT_COMPRESS == 1
@@ -118,22 +168,33 @@ void tuxtxt_decompress_page(int p, int sp, unsigned char* buffer)
 		}
 
 #elif TUXTXT_COMPRESS == 2
-	if (pg->pData)
+	if (pg->pData && pg->ziplen)
 	{
+		/* runs are rebuilt from the bitmask a byte at a time, empty bytes
+		 * continue the last character */
 		int i,j=0;
-		char c=0x20;
-		for (i = 0; i < 23*40; i++)
+		unsigned char c=0x20;
+		for (i = 0; i < 23*40; i += 8)
 		{
-		    if (pg->bitmask[i>>3] & 0x80>>(i&0x07))
-				c = pg->pData[j++];
-		    buffer[i] = c;
+			unsigned char m = pg->bitmask[i>>3];
+			if (!m)
+			{
+				memset(buffer + i, c, 8);
+				continue;
+			}
+			for (int b = 0; b < 8; b++)
+			{
+				if (m & (0x80 >> b))
+					c = pg->pData[j++];
+				buffer[i + b] = c;
+			}
 		}
 #else
 	{
 		memmove(buffer,pg->data,23*40);
 #endif
 	}
-	pthread_mutex_unlock(&tuxtxt_cache_lock);
+	pthread_mutex_unlock(TUXTXT_PAGE_LOCK(p));
 }
 void tuxtxt_next_dec(int *i) /* skip to next decimal */
 {
@@ -362,6 +423,8 @@ void tuxtxt_clear_cache(void)
 	pthread_mutex_lock(&tuxtxt_cache_biglock);
 	pthread_mutex_lock(&tuxtxt_cache_lock);
 	int clear_page, clear_subpage, d26;
+	for (clear_page = 0; clear_page < 9; clear_page++)
+		pthread_mutex_lock(&tuxtxt_page_lock[clear_page]);
 	tuxtxt_cache.maxadippg  = -1;
 	tuxtxt_cache.bttok      = 0;
 	tuxtxt_cache.cached_pages  = 0;
@@ -395,11 +458,8 @@ void tuxtxt_clear_cache(void)
 							free(p->ext->p26[d26]);
 					free(p->ext);
 				}
-#if TUXTXT_COMPRESS >0
-				if (tuxtxt_cache.astCachetable[clear_page][clear_subpage]->pData)
-					free(tuxtxt_cache.astCachetable[clear_page][clear_subpage]->pData);
-#endif
-				free(tuxtxt_cache.astCachetable[clear_page][clear_subpage]);
+				/* pData stays with the page for reuse */
+				tuxtxt_page_free(tuxtxt_cache.astCachetable[clear_page][clear_subpage]);
 				tuxtxt_cache.astCachetable[clear_page][clear_subpage] = 0;
 			}
 	for (clear_page = 0; clear_page < 9; clear_page++)
@@ -422,6 +482,8 @@ void tuxtxt_clear_cache(void)
 #if TUXTXT_DEBUG
 	printf("TuxTxt cache cleared\n");
 #endif
+	for (clear_page = 0; clear_page < 9; clear_page++)
+		pthread_mutex_unlock(&tuxtxt_page_lock[clear_page]);
 	pthread_mutex_unlock(&tuxtxt_cache_lock);
 	pthread_mutex_unlock(&tuxtxt_cache_biglock);
 }
@@ -519,12 +581,10 @@ void tuxtxt_erase_page(int magazine)
 		memset(&(pg->pageinfo), 0, sizeof(tstPageinfo));	/* struct pageinfo */
 		memset(pg->p0, ' ', 24);
 #if TUXTXT_COMPRESS == 1
-		if (pg->pData) {
-			free(pg->pData);
-			pg->pData = NULL;
-		}
+		pg->ziplen = 0;
 #elif TUXTXT_COMPRESS == 2
 		memset(pg->bitmask, 0, 23*5);
+		pg->ziplen = 0;
 #else
 		memset(pg->data, ' ', 23*40);
 #endif
@@ -557,13 +617,13 @@ void tuxtxt_allocate_cache(int magazine)
 	/* check cachetable and allocate memory if needed */
 	if (tuxtxt_cache.astCachetable[tuxtxt_cache.current_page[magazine]][tuxtxt_cache.current_subpage[magazine]] == 0)
 	{
-		tuxtxt_cache.astCachetable[tuxtxt_cache.current_page[magazine]][tuxtxt_cache.current_subpage[magazine]] = (tstCachedPage*) malloc(sizeof(tstCachedPage));
-		if (tuxtxt_cache.astCachetable[tuxtxt_cache.current_page[magazine]][tuxtxt_cache.current_subpage[magazine]] )
+		tstCachedPage *pg = tuxtxt_page_alloc();
+		if (pg)
 		{
-#if TUXTXT_COMPRESS >0
-			tuxtxt_cache.astCachetable[tuxtxt_cache.current_page[magazine]][tuxtxt_cache.current_subpage[magazine]]->pData = 0;
-#endif
+			pthread_mutex_lock(TUXTXT_PAGE_LOCK(tuxtxt_cache.current_page[magazine]));
+			tuxtxt_cache.astCachetable[tuxtxt_cache.current_page[magazine]][tuxtxt_cache.current_subpage[magazine]] = pg;
 			tuxtxt_erase_page(magazine);
+			pthread_mutex_unlock(TUXTXT_PAGE_LOCK(tuxtxt_cache.current_page[magazine]));
 			tuxtxt_cache.cached_pages++;
 		}
 		else // Be a little verbose in case a crash is going to happen.
@@ -755,6 +815,7 @@ void *tuxtxt_CacheThread(void * /*arg*/)
 						tuxtxt_cache.astCachetable[tuxtxt_cache.current_page[magazine]][tuxtxt_cache.current_subpage[magazine]]->ziplen = 0;
 #elif TUXTXT_COMPRESS == 2
 						memset(tuxtxt_cache.astCachetable[tuxtxt_cache.current_page[magazine]][tuxtxt_cache.current_subpage[magazine]]->bitmask, 0, 23*5);
+						tuxtxt_cache.astCachetable[tuxtxt_cache.current_page[magazine]][tuxtxt_cache.current_subpage[magazine]]->ziplen = 0;
 #else
 						memset(tuxtxt_cache.astCachetable[tuxtxt_cache.current_page[magazine]][tuxtxt_cache.current_subpage[magazine]]->data, ' ', 23*40);
 #endif
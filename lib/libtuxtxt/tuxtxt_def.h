@@ -78,8 +78,11 @@ typedef struct
 #if TUXTXT_COMPRESS == 1
 	unsigned char * pData;/* packet 1-23 */
 	unsigned short ziplen;
+	unsigned short zipcap;	/* allocated size of pData */
 #elif TUXTXT_COMPRESS == 2
 	unsigned char * pData;/* packet 1-23 */
+	unsigned short ziplen;	/* used bytes of pData = set bits in bitmask */
+	unsigned short zipcap;	/* allocated size of pData */
 	unsigned char bitmask[23*5];
 #else
 	unsigned char data[23*40];	/* packet 1-23 */
@@ -35,10 +35,13 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <poll.h>
+#include <fcntl.h>
 #include "upnpclient.h"
 #include <algorithm>
+#include <map>
 #include <errno.h>
 #include <stdio.h>
+#include <pthread.h>
 
 struct ToLower
 {
@@ -359,22 +362,259 @@ CUPnPDevice::CUPnPDevice(std::string url)
 	xmlFreeDoc(parser);
 }
 
+/* the services point back to their device, so copies need their own */
+CUPnPDevice::CUPnPDevice(const CUPnPDevice &dev)
+{
+	*this = dev;
+}
+
+CUPnPDevice& CUPnPDevice::operator=(const CUPnPDevice &dev)
+{
+	if (this == &dev)
+		return *this;
+
+	descurl = dev.descurl;
+	services = dev.services;
+	icons = dev.icons;
+	friendlyname = dev.friendlyname;
+	devicetype = dev.devicetype;
+	manufacturer = dev.manufacturer;
+	manufacturerurl = dev.manufacturerurl;
+	modeldescription = dev.modeldescription;
+	modelname = dev.modelname;
+	modelnumber = dev.modelnumber;
+	modelurl = dev.modelurl;
+	serialnumber = dev.serialnumber;
+	udn = dev.udn;
+	upc = dev.upc;
+
+	std::list<CUPnPService>::iterator i;
+	for (i = services.begin(); i != services.end(); ++i)
+		i->device = this;
+	return *this;
+}
+
 CUPnPDevice::~CUPnPDevice()
 {
 }
 
+/* idle keep-alive connections by "host:port", shared by all devices and threads */
+#define HTTP_IDLE_MAX		4
+#define HTTP_TIMEOUT		4000
+
+static std::multimap<std::string, int> http_idle;
+static pthread_mutex_t http_idle_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int http_get_idle(const std::string &key)
+{
+	int fd = -1;
+	pthread_mutex_lock(&http_idle_mutex);
+	std::multimap<std::string, int>::iterator it = http_idle.find(key);
+	if (it != http_idle.end())
+	{
+		fd = it->second;
+		http_idle.erase(it);
+	}
+	pthread_mutex_unlock(&http_idle_mutex);
+	return fd;
+}
+
+static void http_put_idle(const std::string &key, int fd)
+{
+	pthread_mutex_lock(&http_idle_mutex);
+	if (http_idle.count(key) < HTTP_IDLE_MAX)
+	{
+		http_idle.insert(std::make_pair(key, fd));
+		fd = -1;
+	}
+	pthread_mutex_unlock(&http_idle_mutex);
+	if (fd > -1)
+		close(fd);
+}
+
+static int http_connect(const std::string &hostname, int port)
+{
+	struct addrinfo hints, *ai;
+	char portstr[8];
+	int t_socket;
+
+	t_socket = socket(PF_INET, SOCK_STREAM, 0);
+	if (t_socket < 0)
+		throw std::runtime_error(std::string("create TCP socket"));
+
+	/* descriptions are fetched from several threads, gethostbyname() is not reentrant */
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	snprintf(portstr, sizeof(portstr), "%d", port);
+	if (getaddrinfo(hostname.c_str(), portstr, &hints, &ai) || !ai)
+	{
+		close(t_socket);
+		throw std::runtime_error(std::string("resolve name"));
+	}
+
+	/* a LOCATION on an unreachable network must not block for minutes */
+	int flags = fcntl(t_socket, F_GETFL);
+	fcntl(t_socket, F_SETFL, flags | O_NONBLOCK);
+	int err = 0;
+	if (connect(t_socket, ai->ai_addr, ai->ai_addrlen))
+	{
+		err = errno;
+		if (err == EINPROGRESS)
+		{
+			struct pollfd fds[1];
+			fds[0].fd = t_socket;
+			fds[0].events = POLLOUT;
+			socklen_t len = sizeof(err);
+			int result = poll(fds, 1, HTTP_TIMEOUT);
+			if (result < 0)
+				err = errno;
+			else if (result == 0)
+				err = ETIMEDOUT;
+			else if (getsockopt(t_socket, SOL_SOCKET, SO_ERROR, &err, &len))
+				err = errno;
+		}
+	}
+	freeaddrinfo(ai);
+	if (err)
+	{
+		close(t_socket);
+		throw std::runtime_error(std::string("connect: ") + strerror(err));
+	}
+	fcntl(t_socket, F_SETFL, flags);
+	return t_socket;
+}
+
+/* append what arrives within the timeout, false on close, error or timeout */
+static bool http_fill(int fd, std::string &in)
+{
+	char buf[16384];
+	struct pollfd fds[1];
+	fds[0].fd = fd;
+	fds[0].events = POLLIN;
+
+	int result = poll(fds, 1, HTTP_TIMEOUT);
+	if (result < 0) {
+		printf("CUPnPDevice::HTTP: poll error %s\n", strerror(errno));
+		return false;
+	}
+	if (result == 0) {
+		printf("CUPnPDevice::HTTP: poll timeout\n");
+		return false;
+	}
+	int received = recv(fd, buf, sizeof(buf), 0);
+	if (received <= 0)
+		return false;
+	in.append(buf, received);
+	return true;
+}
+
+/* one request/response on fd. Returns header, empty line and the (dechunked)
+   body like the old HTTP/1.0 code did, sets keep if the connection can be
+   used again. An empty string means nothing came back at all. */
+static std::string http_exchange(int fd, const std::string &request, bool &keep)
+{
+	std::string in, header, body;
+	std::string::size_type pos;
+
+	keep = false;
+	if (send(fd, request.c_str(), request.size(), MSG_NOSIGNAL) != (ssize_t) request.size())
+		return "";
+
+	while ((pos = in.find("\r\n\r\n")) == std::string::npos)
+		if (!http_fill(fd, in))
+			return in;
+
+	header = in.substr(0, pos);
+	in.erase(0, pos + 4);
+
+	std::string lheader = header;
+	std::transform(lheader.begin(), lheader.end(), lheader.begin(), ToLower());
+
+	long length = -1;
+	bool chunked = false;
+	keep = lheader.substr(0, 8) == "http/1.1";
+	std::istringstream hs(lheader);
+	std::string line;
+	while (getline(hs, line))
+	{
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+		if (line.substr(0, 15) == "content-length:")
+			length = atol(line.c_str() + 15);
+		else if (line.substr(0, 18) == "transfer-encoding:" && line.find("chunked") != std::string::npos)
+			chunked = true;
+		else if (line.substr(0, 11) == "connection:")
+		{
+			if (line.find("close") != std::string::npos)
+				keep = false;
+			else if (line.find("keep-alive") != std::string::npos)
+				keep = true;
+		}
+	}
+
+	if (chunked)
+	{
+		for (;;)
+		{
+			while ((pos = in.find("\r\n")) == std::string::npos)
+				if (!http_fill(fd, in))
+					goto broken;
+			unsigned long size = strtoul(in.c_str(), NULL, 16);
+			in.erase(0, pos + 2);
+			if (size == 0)
+			{
+				/* trailers up to the empty line */
+				while ((pos = in.find("\r\n")) != 0)
+				{
+					if (pos == std::string::npos)
+					{
+						if (!http_fill(fd, in))
+							goto broken;
+						continue;
+					}
+					in.erase(0, pos + 2);
+				}
+				break;
+			}
+			while (in.size() < size + 2)
+				if (!http_fill(fd, in))
+					goto broken;
+			body.append(in, 0, size);
+			in.erase(0, size + 2);
+		}
+	}
+	else if (length >= 0)
+	{
+		while ((long) in.size() < length)
+			if (!http_fill(fd, in))
+				goto broken;
+		body = in.substr(0, length);
+	}
+	else
+	{
+		/* no length, the body ends with the connection */
+		while (http_fill(fd, in))
+			;
+		body = in;
+		keep = false;
+	}
+	return header + "\r\n\r\n" + body;
+
+broken:
+	keep = false;
+	return header + "\r\n\r\n" + body + in;
+}
+
 std::string CUPnPDevice::HTTP(std::string url, std::string post, std::string action)
 {
 	std::string portname;
 	std::string hostname;
 	std::string path;
-	int port, t_socket, received;
-	std::stringstream command, reply;
-	std::string commandstr, line;
-	struct sockaddr_in socktcp;
-	struct hostent *hp;
+	int port;
+	std::stringstream command;
+	std::string commandstr;
 	std::string::size_type pos1, pos2;
-	char buf[4096];
 
 	if (url.substr(0,7) != "http://")
 		return "";
@@ -400,14 +640,14 @@ std::string CUPnPDevice::HTTP(std::string url, std::string post, std::string act
 	path = url.substr(pos2);
 
 	if (!post.empty())
-		command << "POST " << path << " HTTP/1.0\r\n";
+		command << "POST " << path << " HTTP/1.1\r\n";
 	else
-		command << "GET " << path << " HTTP/1.0\r\n";
+		command << "GET " << path << " HTTP/1.1\r\n";
 
 	command << "Host: " << hostname << ":" << port << "\r\n";
 	command << "User-Agent: TuxBox\r\n";
 	command << "Accept: text/xml\r\n";
-	command << "Connection: Close\r\n";
+	command << "Connection: keep-alive\r\n";
 
 	if (!post.empty())
 	{
@@ -423,55 +663,32 @@ std::string CUPnPDevice::HTTP(std::string url, std::string post, std::string act
 	if (!post.empty())
 		command << post;
 
-	t_socket = socket(PF_INET, SOCK_STREAM, 0);
-	if (!t_socket)
-		throw std::runtime_error(std::string("create TCP socket"));
+	commandstr = command.str();
 
-	hp = gethostbyname(hostname.c_str());
-	if (!hp)
-		throw std::runtime_error(std::string("resolve name"));
+	std::stringstream key;
+	key << hostname << ":" << port;
 
-	memset(&socktcp, 0, sizeof(struct sockaddr_in));
-	socktcp.sin_family = AF_INET;
-	socktcp.sin_port = htons(port);
-	memmove((char *)&socktcp.sin_addr, hp->h_addr, hp->h_length);
+	/* an idle connection may have been closed by the server meanwhile,
+	   if nothing comes back on it, try once more on a new one */
+	int t_socket = http_get_idle(key.str());
+	bool reused = t_socket > -1;
+	if (!reused)
+		t_socket = http_connect(hostname, port);
 
-	if (connect(t_socket, (struct sockaddr*) &socktcp, sizeof(struct sockaddr_in)))
+	bool keep;
+	std::string reply = http_exchange(t_socket, commandstr, keep);
+	if (reply.empty() && reused)
 	{
 		close(t_socket);
-		throw std::runtime_error(std::string("connect"));
+		t_socket = http_connect(hostname, port);
+		reply = http_exchange(t_socket, commandstr, keep);
 	}
 
-	commandstr = command.str();
-	send(t_socket, commandstr.c_str(), commandstr.size(), 0);
-#if 0
-	while ((received = recv(t_socket, buf, sizeof(buf)-1, 0)) > 0)
-	{
-		buf[received] = 0;
-		reply << buf;
-	}
-#endif
-	struct pollfd fds[1];
-	fds[0].fd = t_socket;
-	fds[0].events = POLLIN;
-	while (true) {
-		int result = poll(fds, 1, 4000);
-		if (result < 0) {
-			printf("CUPnPDevice::HTTP: poll error %s\n", strerror(errno));
-			break;
-		}
-		if (result == 0) {
-			printf("CUPnPDevice::HTTP: poll timeout\n");
-			break;
-		}
-		received = recv(t_socket, buf, sizeof(buf)-1, 0);
-		if (received <= 0)
-			break;
-		buf[received] = 0;
-		reply << buf;
-	}
-	close(t_socket);
-	return reply.str();
+	if (keep)
+		http_put_idle(key.str(), t_socket);
+	else
+		close(t_socket);
+	return reply;
 }
 
 std::list<UPnPAttribute> CUPnPDevice::SendSOAP(std::string servicename, std::string action, std::list<UPnPAttribute> attribs)
@@ -0,0 +1,436 @@
+/***********************************************************************************
+ *   UPNPDiscovery.cpp
+ *
+ *   background SSDP discovery with a device cache
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ ***********************************************************************************/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <iostream>
+#include <stdexcept>
+#include <string.h>
+#include <strings.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <stdio.h>
+#include <system/set_threadname.h>
+#include "upnpclient.h"
+
+static time_t monotonic_sec(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec;
+}
+
+/* value of a header line, case insensitive name, whitespace trimmed */
+static bool ssdp_header(const std::string &line, const char *name, std::string &value)
+{
+	size_t len = strlen(name);
+	if (line.size() <= len || strncasecmp(line.c_str(), name, len) || line[len] != ':')
+		return false;
+
+	std::string::size_type pos1 = line.find_first_not_of(" \t", len + 1);
+	if (pos1 == std::string::npos)
+	{
+		value = "";
+		return true;
+	}
+	std::string::size_type pos2 = line.find_last_not_of(" \t\r");
+	value = line.substr(pos1, pos2 - pos1 + 1);
+	return true;
+}
+
+CUPnPDiscovery::CUPnPDiscovery(std::string service)
+{
+	m_service = service;
+	m_socket = NULL;
+	m_notify_socket = -1;
+	m_wakeup[0] = m_wakeup[1] = -1;
+	m_running = false;
+	m_generation = 0;
+	m_last_search = 0;
+	m_fetcher_count = 0;
+
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&m_cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+CUPnPDiscovery::~CUPnPDiscovery()
+{
+	if (m_running)
+	{
+		pthread_mutex_lock(&m_mutex);
+		m_running = false;
+		pthread_cond_broadcast(&m_cond);
+		pthread_mutex_unlock(&m_mutex);
+
+		if (write(m_wakeup[1], "", 1) < 0)
+			perror("CUPnPDiscovery: wakeup");
+		pthread_join(m_listener, NULL);
+		for (int i = 0; i < m_fetcher_count; i++)
+			pthread_join(m_fetchers[i], NULL);
+	}
+
+	for (cache_map_t::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+		delete it->second.device;
+
+	delete m_socket;
+	if (m_notify_socket > -1)
+		close(m_notify_socket);
+	if (m_wakeup[0] > -1)
+	{
+		close(m_wakeup[0]);
+		close(m_wakeup[1]);
+	}
+	pthread_cond_destroy(&m_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void CUPnPDiscovery::Start()
+{
+	if (m_running)
+		return;
+
+	if (!m_socket)
+		m_socket = new CUPnPSocket();
+
+	if (m_wakeup[0] < 0 && pipe(m_wakeup))
+		throw std::runtime_error(std::string("pipe"));
+
+	/* announcements are a bonus, searching works without them */
+	if (m_notify_socket < 0)
+	{
+		int opt = 1;
+		struct sockaddr_in addr;
+		struct ip_mreq mreq;
+
+		m_notify_socket = socket(PF_INET, SOCK_DGRAM, 0);
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(MULTICAST_PORT);
+		addr.sin_addr.s_addr = INADDR_ANY;
+		mreq.imr_multiaddr.s_addr = inet_addr(MULTICAST_IP);
+		mreq.imr_interface.s_addr = INADDR_ANY;
+
+		if (m_notify_socket < 0 ||
+		    setsockopt(m_notify_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) ||
+		    bind(m_notify_socket, (struct sockaddr*) &addr, sizeof(addr)) ||
+		    setsockopt(m_notify_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)))
+		{
+			perror("CUPnPDiscovery: notify socket");
+			if (m_notify_socket > -1)
+				close(m_notify_socket);
+			m_notify_socket = -1;
+		}
+	}
+
+	m_running = true;
+	if (pthread_create(&m_listener, NULL, ListenThread, this))
+	{
+		m_running = false;
+		throw std::runtime_error(std::string("create thread"));
+	}
+	for (m_fetcher_count = 0; m_fetcher_count < UPNP_FETCH_WORKERS; m_fetcher_count++)
+	{
+		if (pthread_create(&m_fetchers[m_fetcher_count], NULL, FetchThread, this))
+		{
+			perror("CUPnPDiscovery: fetch thread");
+			break;
+		}
+	}
+}
+
+void CUPnPDiscovery::Search()
+{
+	Start();
+
+	pthread_mutex_lock(&m_mutex);
+	m_last_search = monotonic_sec();
+	pthread_mutex_unlock(&m_mutex);
+
+	m_socket->Search(m_service);
+}
+
+void CUPnPDiscovery::Flush()
+{
+	pthread_mutex_lock(&m_mutex);
+	/* running fetches find their entry gone and drop the result */
+	for (cache_map_t::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+		delete it->second.device;
+	m_cache.clear();
+	m_pending.clear();
+	m_last_search = 0;
+	m_generation++;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+/* devices with a fetched description; searches again in the background
+   if the last search is a while ago, so stale entries get refreshed or expire */
+std::vector<CUPnPDevice> CUPnPDiscovery::GetDevices()
+{
+	std::vector<CUPnPDevice> devices;
+
+	Start();
+
+	pthread_mutex_lock(&m_mutex);
+	bool search = !m_last_search || monotonic_sec() - m_last_search > UPNP_SEARCH_INTERVAL;
+	for (cache_map_t::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+		if (it->second.device)
+			devices.push_back(*it->second.device);
+	pthread_mutex_unlock(&m_mutex);
+
+	if (search)
+		Search();
+
+	return devices;
+}
+
+/* wait until a device is known or nothing is left to wait for */
+bool CUPnPDiscovery::WaitForDevices(int timeout_ms)
+{
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += timeout_ms / 1000;
+	deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L)
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	bool found = false;
+	pthread_mutex_lock(&m_mutex);
+	while (m_running)
+	{
+		for (cache_map_t::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+			if (it->second.device)
+				found = true;
+		if (found)
+			break;
+		/* descriptions still being fetched show up later via GetGeneration() */
+		if (pthread_cond_timedwait(&m_cond, &m_mutex, &deadline) == ETIMEDOUT)
+			break;
+	}
+	pthread_mutex_unlock(&m_mutex);
+	return found;
+}
+
+unsigned int CUPnPDiscovery::GetGeneration()
+{
+	pthread_mutex_lock(&m_mutex);
+	unsigned int gen = m_generation;
+	pthread_mutex_unlock(&m_mutex);
+	return gen;
+}
+
+void CUPnPDiscovery::HandleMessage(const char *msg)
+{
+	std::string data(msg), line, value;
+	std::string location, usn, nt, nts;
+	int max_age = UPNP_DEFAULT_MAX_AGE;
+	bool notify = !strncmp(msg, "NOTIFY", 6);
+	std::string::size_type start = 0, end;
+
+	if (!notify && strncmp(msg, "HTTP/", 5))
+		return;
+
+	while (start < data.size())
+	{
+		end = data.find('\n', start);
+		if (end == std::string::npos)
+			end = data.size();
+		line = data.substr(start, end - start);
+		start = end + 1;
+
+		if (ssdp_header(line, "location", value))
+			location = value;
+		else if (ssdp_header(line, "usn", value))
+			usn = value;
+		else if (ssdp_header(line, notify ? "nt" : "st", value))
+			nt = value;
+		else if (ssdp_header(line, "nts", value))
+			nts = value;
+		else if (ssdp_header(line, "cache-control", value))
+		{
+			std::string::size_type pos = value.find("max-age");
+			if (pos != std::string::npos && (pos = value.find('=', pos)) != std::string::npos)
+				max_age = atoi(value.c_str() + pos + 1);
+		}
+	}
+
+	std::string uuid = usn.substr(0, usn.find("::"));
+
+	pthread_mutex_lock(&m_mutex);
+	if (notify && nts == "ssdp:byebye")
+	{
+		/* sent once per device, service and embedded device, all carry the uuid */
+		cache_map_t::iterator it = m_cache.begin();
+		while (it != m_cache.end())
+		{
+			if (!uuid.empty() && it->second.uuid == uuid)
+			{
+				delete it->second.device;
+				m_cache.erase(it++);
+				m_generation++;
+			}
+			else
+				++it;
+		}
+	}
+	else if (nt == m_service && location.substr(0, 7) == "http://")
+	{
+		cache_map_t::iterator it = m_cache.find(location);
+		if (it == m_cache.end())
+		{
+			cache_entry entry;
+			entry.device = NULL;
+			entry.fetching = true;
+			it = m_cache.insert(std::make_pair(location, entry)).first;
+			m_pending.push_back(location);
+		}
+		it->second.uuid = uuid;
+		it->second.expires = monotonic_sec() + max_age;
+		pthread_cond_broadcast(&m_cond);
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void CUPnPDiscovery::Expire(time_t now)
+{
+	pthread_mutex_lock(&m_mutex);
+	cache_map_t::iterator it = m_cache.begin();
+	while (it != m_cache.end())
+	{
+		if (!it->second.fetching && it->second.expires < now)
+		{
+			delete it->second.device;
+			m_cache.erase(it++);
+			m_generation++;
+		}
+		else
+			++it;
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void CUPnPDiscovery::Listen()
+{
+	struct pollfd fds[3];
+	int nfds = 0;
+	char buf[1536];
+
+	fds[nfds].fd = m_wakeup[0];
+	fds[nfds++].events = POLLIN;
+	fds[nfds].fd = m_socket->GetFD();
+	fds[nfds++].events = POLLIN;
+	if (m_notify_socket > -1)
+	{
+		fds[nfds].fd = m_notify_socket;
+		fds[nfds++].events = POLLIN;
+	}
+
+	while (m_running)
+	{
+		int result = poll(fds, nfds, 1000);
+		if (result < 0 && errno != EINTR)
+		{
+			perror("CUPnPDiscovery: poll");
+			break;
+		}
+		for (int i = 1; result > 0 && i < nfds; i++)
+		{
+			if (!(fds[i].revents & POLLIN))
+				continue;
+			int len = recv(fds[i].fd, buf, sizeof(buf) - 1, 0);
+			if (len <= 0)
+				continue;
+			buf[len] = 0;
+			HandleMessage(buf);
+		}
+		Expire(monotonic_sec());
+	}
+}
+
+void CUPnPDiscovery::Fetch()
+{
+	pthread_mutex_lock(&m_mutex);
+	while (m_running)
+	{
+		if (m_pending.empty())
+		{
+			pthread_cond_wait(&m_cond, &m_mutex);
+			continue;
+		}
+		std::string location = m_pending.front();
+		m_pending.pop_front();
+		pthread_mutex_unlock(&m_mutex);
+
+		CUPnPDevice *device = NULL;
+		try
+		{
+			device = new CUPnPDevice(location);
+		}
+		catch (std::runtime_error& error)
+		{
+			std::cout << "error " << error.what() << "\n";
+		}
+
+		pthread_mutex_lock(&m_mutex);
+		/* failed ones stay in the cache without device until they expire,
+		   so they are not fetched again on every reply */
+		cache_map_t::iterator it = m_cache.find(location);
+		if (it != m_cache.end() && it->second.fetching)
+		{
+			it->second.fetching = false;
+			it->second.device = device;
+			if (device)
+				m_generation++;
+			device = NULL;
+		}
+		delete device;
+		pthread_cond_broadcast(&m_cond);
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void *CUPnPDiscovery::ListenThread(void *arg)
+{
+	set_threadname("upnp:discover");
+	static_cast<CUPnPDiscovery *>(arg)->Listen();
+	return NULL;
+}
+
+void *CUPnPDiscovery::FetchThread(void *arg)
+{
+	set_threadname("upnp:fetch");
+	static_cast<CUPnPDiscovery *>(arg)->Fetch();
+	return NULL;
+}
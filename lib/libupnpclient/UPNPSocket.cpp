@@ -22,6 +22,7 @@
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <set>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -74,16 +75,12 @@ void CUPnPSocket::SetTTL(int ttl)
 		throw std::runtime_error(std::string("set ttl"));
 }
 
-std::vector<CUPnPDevice> CUPnPSocket::Discover(std::string service)
+void CUPnPSocket::Search(std::string service)
 {
 	struct sockaddr_in sockudp;
-	std::stringstream command, reply;
-	std::string commandstr, line;
-	std::vector<CUPnPDevice> devices;
+	std::stringstream command;
+	std::string commandstr;
 	int result;
-	std::string::size_type pos;
-	struct pollfd fds[1];
-	char bufr[1536];
 
 	memset(&sockudp, 0, sizeof(struct sockaddr_in));
 	sockudp.sin_family = AF_INET;
@@ -104,6 +101,20 @@ std::vector<CUPnPDevice> CUPnPSocket::Discover(std::string service)
 		throw std::runtime_error(std::string(strerror(errno)));
 	}
 //	result = sendto(m_socket, commandstr.c_str(), commandstr.size(), 0, (struct sockaddr*) &sockudp, sizeof(struct sockaddr_in));
+}
+
+std::vector<CUPnPDevice> CUPnPSocket::Discover(std::string service)
+{
+	std::stringstream reply;
+	std::string line;
+	std::vector<CUPnPDevice> devices;
+	std::set<std::string> locations;
+	int result;
+	std::string::size_type pos;
+	struct pollfd fds[1];
+	char bufr[1536];
+
+	Search(service);
 
 	fds[0].fd = m_socket;
 	fds[0].events = POLLIN;
@@ -116,7 +127,7 @@ std::vector<CUPnPDevice> CUPnPSocket::Discover(std::string service)
 		if (result == 0)
 			return devices;
 
-		result = recv(m_socket, bufr, sizeof(bufr), 0);
+		result = recv(m_socket, bufr, sizeof(bufr) - 1, 0);
 		if (result < 0)
 			throw std::runtime_error(std::string("recv"));
 
@@ -137,12 +148,8 @@ std::vector<CUPnPDevice> CUPnPSocket::Discover(std::string service)
 				line.erase(0, 9);
 				while ((!line.empty()) && ((line[0] == ' ') || (line[0] == '\t')))
 					line.erase(0, 1);
-				if (line.substr(0,7) == "http://")
+				if (line.substr(0,7) == "http://" && locations.insert(line).second)
 				{
-					std::vector<CUPnPDevice>::iterator i;
-					for (i=devices.begin(); i != devices.end(); ++i)
-						if (line == i->descurl)
-							goto found;
 					try
 					{
 						devices.push_back(CUPnPDevice(line));
@@ -152,7 +159,6 @@ std::vector<CUPnPDevice> CUPnPSocket::Discover(std::string service)
 						std::cout << "error " << error.what() << "\n";
 					}
 				}
-				found: ;
 			}
 		}
 	}
@@ -25,7 +25,10 @@
 #include <utility>
 #include <list>
 #include <vector>
+#include <map>
 #include <string>
+#include <time.h>
+#include <pthread.h>
 
 #define MULTICAST_PORT 1900
 #define MULTICAST_IP   "239.255.255.250"
@@ -76,6 +79,8 @@ public:
   std::list<UPnPIcon> GetIcons() const { return icons; };
 
   CUPnPDevice(std::string url);
+  CUPnPDevice(const CUPnPDevice &dev);
+  CUPnPDevice& operator=(const CUPnPDevice &dev);
   ~CUPnPDevice();
 };
 
@@ -109,11 +114,73 @@ public:
   ~CUPnPSocket();
 
   void SetTTL(int ttl);
+  void Search(std::string service);
   std::vector<CUPnPDevice> Discover(std::string service);
+  int GetFD() const { return m_socket; }
 
 private:
   int m_socket;
 
 };
 
+/******************************************
+ * Class: CUPnPDiscovery
+ *
+ * keeps the devices offering a service, fed by
+ * M-SEARCH replies and NOTIFY announcements from
+ * a background thread; descriptions are fetched
+ * by a few worker threads
+ ******************************************/
+
+#define UPNP_SEARCH_TIMEOUT	4000	/* ms, MX 3 plus some slack */
+#define UPNP_SEARCH_INTERVAL	60	/* s, search again on GetDevices() after this */
+#define UPNP_DEFAULT_MAX_AGE	1800	/* s, if the announcement has no max-age */
+#define UPNP_FETCH_WORKERS	4
+
+class CUPnPDiscovery
+{
+public:
+  CUPnPDiscovery(std::string service);
+  ~CUPnPDiscovery();
+
+  void Start();
+  void Search();
+  void Flush();
+  std::vector<CUPnPDevice> GetDevices();
+  bool WaitForDevices(int timeout_ms);
+  unsigned int GetGeneration();
+
+private:
+  struct cache_entry
+  {
+    CUPnPDevice *device;
+    std::string uuid;
+    time_t      expires;
+    bool        fetching;
+  };
+  typedef std::map<std::string, cache_entry> cache_map_t;
+
+  std::string     m_service;
+  CUPnPSocket    *m_socket;
+  int             m_notify_socket;
+  int             m_wakeup[2];
+  bool            m_running;
+  cache_map_t     m_cache;
+  std::list<std::string> m_pending;
+  unsigned int    m_generation;
+  time_t          m_last_search;
+  pthread_t       m_listener;
+  pthread_t       m_fetchers[UPNP_FETCH_WORKERS];
+  int             m_fetcher_count;
+  pthread_mutex_t m_mutex;
+  pthread_cond_t  m_cond;
+
+  void Listen();
+  void Fetch();
+  void HandleMessage(const char *msg);
+  void Expire(time_t now);
+  static void *ListenThread(void *arg);
+  static void *FetchThread(void *arg);
+};
+
 #endif
@@ -41,10 +41,15 @@
 /* # Structs # */
 /* ########### */
 
+/* The input is real, so it is packed into a complex sequence of half the
+ * length (even samples real, odd samples imaginary), transformed with a
+ * FFT of size FFT_HALF_SIZE and split into the real spectrum afterwards. */
+#define FFT_HALF_SIZE (FFT_BUFFER_SIZE / 2)
+
 struct _struct_fft_state {
     /* Temporary data stores to perform FFT in. */
-    float real[FFT_BUFFER_SIZE];
-    float imag[FFT_BUFFER_SIZE];
+    float real[FFT_HALF_SIZE];
+    float imag[FFT_HALF_SIZE];
 };
 
 /* ############################# */
@@ -61,7 +66,7 @@ static int reverseBits(unsigned int initial);
 /* #################### */
 
 /* Table to speed up bit reverse copy */
-static unsigned int bitReverse[FFT_BUFFER_SIZE];
+static unsigned int bitReverse[FFT_HALF_SIZE];
 
 /* The next two tables could be made to use less space in memory, since they
  * overlap hugely, but hey. */
@@ -89,7 +94,7 @@ fft_state *fft_init(void) {
     state = (fft_state *) malloc (sizeof(fft_state));
     if(!state) return NULL;
 
-    for(i = 0; i < FFT_BUFFER_SIZE; i++) {
+    for(i = 0; i < FFT_HALF_SIZE; i++) {
 	bitReverse[i] = reverseBits(i);
     }
     for(i = 0; i < FFT_BUFFER_SIZE / 2; i++) {
@@ -147,10 +152,11 @@ static void fft_prepare(const sound_sample *input, float * re, float * im) {
     float *realptr = re;
     float *imagptr = im;
     
-    /* Get input, in reverse bit order */
-    for(i = 0; i < FFT_BUFFER_SIZE; i++) {
-	*realptr++ = input[bitReverse[i]];
-	*imagptr++ = 0;
+    /* Get input pairs, in reverse bit order */
+    for(i = 0; i < FFT_HALF_SIZE; i++) {
+	const sound_sample *pair = input + (bitReverse[i] << 1);
+	*realptr++ = pair[0];
+	*imagptr++ = pair[1];
     }
 }
 
@@ -165,43 +171,34 @@ static void fft_prepare(const sound_sample *input, float * re, float * im) {
  * table, and the other at FFT_BUFFER_SIZE - i, except for i = 0 and
  * FFT_BUFFER_SIZE which would otherwise get float (and then 4* when squared)
  * the contributions.
+ *
+ * re/im hold the half size transform Z of the packed input. The spectrum of
+ * the real input is rebuilt from it as
+ *   X[k] = (Z[k] + conj(Z[M-k])) / 2 + W^k * (Z[k] - conj(Z[M-k])) / 2i
+ * with M = FFT_HALF_SIZE and W^k = costable[k] + i * sintable[k].
  */
 static void fft_output(const float * re, const float * im, float *output) {
-    float *outputptr = output;
-    const float *realptr   = re;
-    const float *imagptr   = im;
-    float *endptr    = output + FFT_BUFFER_SIZE / 2;
- 
-#ifdef DEBUG
-    unsigned int i, j;
-#endif
- 
-    while(outputptr <= endptr) {
-	*outputptr = (*realptr * *realptr) + (*imagptr * *imagptr);
-	outputptr++; realptr++; imagptr++;
-    }
-    /* Do divisions to keep the constant and highest frequency terms in scale
-     * with the other terms. */
-    *output /= 4;
-    *endptr /= 4;
+    unsigned int k;
+    float x;
 
-#ifdef DEBUG
-    printf("Recalculated input:\n");
-    for(i = 0; i < FFT_BUFFER_SIZE; i++) {
-        float val_real = 0;
-        float val_imag = 0;
-	for(j = 0; j < FFT_BUFFER_SIZE; j++) {
-	    float fact_real = cos(- 2 * j * i * PI / FFT_BUFFER_SIZE);
-	    float fact_imag = sin(- 2 * j * i * PI / FFT_BUFFER_SIZE);
-	    val_real += fact_real * re[j] - fact_imag * im[j];
-	    val_imag += fact_real * im[j] + fact_imag * re[j];
-	}
-	printf("%5d = %8f + i * %8f\n", i,
-	       val_real / FFT_BUFFER_SIZE,
-	       val_imag / FFT_BUFFER_SIZE);
+    /* Z[0] and Z[M] are the same point, X[0] and X[M] are real */
+    x = re[0] + im[0];
+    output[0] = x * x / 4;
+    x = re[0] - im[0];
+    output[FFT_HALF_SIZE] = x * x / 4;
+
+    for(k = 1; k < FFT_HALF_SIZE; k++) {
+	unsigned int m = FFT_HALF_SIZE - k;
+	/* even part */
+	float er = (re[k] + re[m]) * 0.5f;
+	float ei = (im[k] - im[m]) * 0.5f;
+	/* odd part */
+	float or_ = (im[k] + im[m]) * 0.5f;
+	float oi = (re[m] - re[k]) * 0.5f;
+	float xr = er + costable[k] * or_ - sintable[k] * oi;
+	float xi = ei + costable[k] * oi + sintable[k] * or_;
+	output[k] = xr * xr + xi * xi;
     }
-    printf("\n");
-#endif
 }
 
 /*
@@ -214,12 +211,14 @@ static void fft_calculate(float * re, float * im) {
     float tmp_real, tmp_imag;
     unsigned int factfact;
     
-    /* Set up some variables to reduce calculation in the loops */
+    /* Set up some variables to reduce calculation in the loops.
+     * The tables are for FFT_BUFFER_SIZE, so the step through them ends
+     * at 2 for the half size transform. */
     exchanges = 1;
     factfact = FFT_BUFFER_SIZE / 2;
 
     /* Loop through the divide and conquer steps */
-    for(i = FFT_BUFFER_SIZE_LOG; i != 0; i--) {
+    for(i = FFT_BUFFER_SIZE_LOG - 1; i != 0; i--) {
 	/* In this step, we have 2 ^ (i - 1) exchange groups, each with
 	 * 2 ^ (FFT_BUFFER_SIZE_LOG - i) exchanges
 	 */
@@ -234,7 +233,7 @@ static void fft_calculate(float * re, float * im) {
 	    fact_imag = sintable[j * factfact];
 	    
 	    /* Loop through all the exchange groups */
-	    for(k = j; k < FFT_BUFFER_SIZE; k += exchanges << 1) {
+	    for(k = j; k < FFT_HALF_SIZE; k += exchanges << 1) {
 		int k1 = k + exchanges;
 		/* newval[k]  := val[k] + factor * val[k1]
 		 * newval[k1] := val[k] - factor * val[k1]
@@ -252,7 +251,7 @@ static void fft_calculate(float * re, float * im) {
 		re[k]  += tmp_real;
 		im[k]  += tmp_imag;
 #ifdef DEBUG
-		for(k1 = 0; k1 < FFT_BUFFER_SIZE; k1++) {
+		for(k1 = 0; k1 < FFT_HALF_SIZE; k1++) {
 		    printf("%5d = %8f + i * %8f\n", k1, real[k1], imag[k1]);
 		}
 #endif
@@ -265,7 +264,7 @@ static void fft_calculate(float * re, float * im) {
 
 static int reverseBits(unsigned int initial) {
     unsigned int reversed = 0, loop;
-    for(loop = 0; loop < FFT_BUFFER_SIZE_LOG; loop++) {
+    for(loop = 0; loop < FFT_BUFFER_SIZE_LOG - 1; loop++) {
 	reversed <<= 1;
 	reversed += (initial & 1);
 	initial >>= 1;
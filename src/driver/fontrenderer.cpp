@@ -238,6 +238,8 @@ Font::Font(FBFontRenderClass *render, FTC_FaceID faceid, const int isize, const
 	font.flags = FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT;
 
 	maxdigitwidth = 0;
+	pthread_mutex_init(&width_mutex, NULL);
+	width_gen = 0;
 
 	scaler.face_id = font.face_id;
 	scaler.width   = isize * 64;
@@ -252,6 +254,20 @@ Font::Font(FBFontRenderClass *render, FTC_FaceID faceid, const int isize, const
 	useFullBG = false;
 }
 
+Font::~Font()
+{
+	pthread_mutex_destroy(&width_mutex);
+}
+
+void Font::clearWidthCache()
+{
+	pthread_mutex_lock(&width_mutex);
+	width_map.clear();
+	width_lru.clear();
+	width_gen++;
+	pthread_mutex_unlock(&width_mutex);
+}
+
 FT_Error Font::getGlyphBitmap(FT_ULong glyph_index, FTC_SBit *sbit)
 {
 	return renderer->getGlyphBitmap(&scaler, glyph_index, sbit);
@@ -261,6 +277,7 @@ int Font::setSize(int isize)
 {
 	int temp = font.width;
 	font.width = font.height = isize;
+	clearWidthCache();
 	scaler.width  = isize * 64;
 	scaler.height = isize * 64;
 
@@ -731,7 +748,55 @@ void Font::RenderString(int x, int y, const int width, const std::string & text,
 	RenderString(x, y, width, text.c_str(), color, boxheight, flags, buffer, stride);
 }
 
+/* max. number of strings in the width cache of each font */
+#define WIDTH_CACHE_SIZE 512
+
 int Font::getRenderWidth(const char *text, const bool utf8_encoded)
+{
+	std::string key(text);
+	key += utf8_encoded ? '\1' : '\0';
+
+	int x = -1;
+	pthread_mutex_lock(&width_mutex);
+	width_map_t::iterator it = width_map.find(key);
+	if (it != width_map.end()) {
+		/* move to front of the LRU list */
+		width_lru.splice(width_lru.begin(), width_lru, it->second);
+		x = it->second->second;
+	}
+	unsigned int gen = width_gen;
+	pthread_mutex_unlock(&width_mutex);
+
+	if (x < 0) {
+		x = calcRenderWidth(text, utf8_encoded);
+		if (x < 0)
+			return x;
+
+		pthread_mutex_lock(&width_mutex);
+		if (gen == width_gen && width_map.find(key) == width_map.end()) {
+			width_lru.push_front(std::make_pair(key, x));
+			width_map[key] = width_lru.begin();
+			if (width_lru.size() > WIDTH_CACHE_SIZE) {
+				width_map.erase(width_lru.back().first);
+				width_lru.pop_back();
+			}
+		}
+		pthread_mutex_unlock(&width_mutex);
+	}
+
+	if (stylemodifier == Font::Embolden)
+	{
+		int spread_by = (fontwidth / 6) - 1;
+		if (spread_by < 1)
+			spread_by = 1;
+
+		x += spread_by;
+	}
+
+	return x;
+}
+
+int Font::calcRenderWidth(const char *text, const bool utf8_encoded)
 {
 	pthread_mutex_lock( &renderer->render_mutex );
 
@@ -786,15 +851,6 @@ int Font::getRenderWidth(const char *text, const bool utf8_encoded)
 		lastindex=index;
 	}
 
-	if (stylemodifier == Font::Embolden)
-	{
-		int spread_by = (fontwidth / 6) - 1;
-		if (spread_by < 1)
-			spread_by = 1;
-
-		x += spread_by;
-	}
-
 	pthread_mutex_unlock( &renderer->render_mutex );
 
 	return x;
@@ -29,6 +29,8 @@
 
 #include <pthread.h>
 #include <string>
+#include <list>
+#include <map>
 #include <inttypes.h>
 
 #include <ft2build.h>
@@ -60,6 +62,17 @@ class Font
 	fb_pixel_t colors[256];
 	bool useFullBG;
 
+	/* LRU cache of measured string widths, keyed by text and encoding.
+	   has its own lock, so that a cache hit does not wait for render_mutex */
+	typedef std::list<std::pair<std::string, int> > width_lru_t;
+	typedef std::map<std::string, width_lru_t::iterator> width_map_t;
+	width_lru_t	width_lru;
+	width_map_t	width_map;
+	pthread_mutex_t	width_mutex;
+	unsigned int	width_gen; /* bumped on clear, drops widths measured with the old size */
+	void clearWidthCache();
+	int calcRenderWidth(const char *text, const bool utf8_encoded);
+
 	inline int int_min(int a, int b) { return (a < b) ? a : b; }
 	inline void paintFontPixel(fb_pixel_t *td, uint8_t src);
 
@@ -94,7 +107,7 @@ class Font
 	int getDescender(){return descender * -1;}
 
 	Font(FBFontRenderClass *render, FTC_FaceID faceid, const int isize, const fontmodifier _stylemodifier);
-	~Font(){}
+	~Font();
 };
 
 class FBFontRenderClass
@@ -31,6 +31,7 @@
 #include <sys/un.h>
 #include <sys/stat.h>
 #include <sys/vfs.h>
+#include <sys/syscall.h>
 #include <errno.h>
 #include <math.h>
 #include <utime.h>
@@ -45,6 +46,7 @@
 
 #include <driver/screen_max.h>
 #include <driver/moviecut.h>
+#include <zapit/client/zapittypes.h>
 
 #define PSI_SIZE 188*2
 #define BUF_SIZE 1395*188
@@ -71,6 +73,7 @@ CMovieCut::CMovieCut()
 	frameBuffer = CFrameBuffer::getInstance();
 	timescale = NULL;
 	percent = 0;
+	vtype = CHANNEL_MPEG2;
 	int dx = 256;
 	x = (((g_settings.screen_EndX - g_settings.screen_StartX) - dx) / 2) + g_settings.screen_StartX;
 	y = g_settings.screen_EndY - 50;
@@ -205,12 +208,27 @@ int CMovieCut::check_pes_start(unsigned char *packet)
 		if (!memcmp(pes, "\x00\x00\x01", 3) && (pes[3] & 0xF0) == 0xE0) // PES start & video type
 		{
 			pes += 4;
-			while (pes < (packet + 188 - 4))
+			while (pes < (packet + 188 - 5))
 			{
-				if (!memcmp(pes, "\x00\x00\x01\xB8", 4)) // GOP detect
-					return 1;
-				else
-					pes++;
+				if (!memcmp(pes, "\x00\x00\x01", 3))
+				{
+					switch (vtype)
+					{
+						case CHANNEL_MPEG4: // SPS, precedes an IDR picture
+							if ((pes[3] & 0x9F) == 0x07 && (pes[3] & 0x60))
+								return 1;
+							break;
+						case CHANNEL_HEVC: // VPS
+							if (pes[3] == 0x40 && pes[4] == 0x01)
+								return 1;
+							break;
+						default: // GOP detect
+							if (pes[3] == 0xB8)
+								return 1;
+							break;
+					}
+				}
+				pes++;
 			}
 		}
 	}
@@ -227,6 +245,32 @@ int CMovieCut::find_gop(unsigned char *buf, int r)
 	return -1;
 }
 
+/* copy up to size bytes at the current file positions, in kernel space if
+   supported (copy_file_range), else through buf. zerocopy is cleared on the
+   first failed kernel copy, so the rest of the file goes the old way */
+ssize_t CMovieCut::copy_data(int srcfd, int dstfd, unsigned char *buf, size_t size, bool &zerocopy)
+{
+#ifdef __NR_copy_file_range
+	if (zerocopy)
+	{
+		ssize_t r = syscall(__NR_copy_file_range, srcfd, NULL, dstfd, NULL, size, 0);
+		if (r >= 0)
+			return r;
+		printf("CMovieCut::%s: copy_file_range failed (%m), using read/write\n", __func__);
+		zerocopy = false;
+	}
+#else
+	zerocopy = false;
+#endif
+	ssize_t r = read(srcfd, buf, size);
+	if (r <= 0)
+		return r;
+	ssize_t wr = write(dstfd, buf, r);
+	if (wr < r)
+		return -1;
+	return r;
+}
+
 off64_t CMovieCut::fake_read(int fd, unsigned char *buf, size_t size, off64_t fsize)
 {
 	off64_t cur = lseek64(fd, 0, SEEK_CUR);
@@ -336,11 +380,13 @@ bool CMovieCut::cutMovie(MI_MOVIE_INFO *minfo)
 	bool need_gop = 0;
 	int was_cancel = 0;
 	bool retval = false;
+	bool zerocopy = true;
 	time_t tt = time(0);
 	time_t tt1;
 
 	off64_t size = minfo->file.Size;
 	off64_t secsize = getSecondSize(minfo);
+	vtype = minfo->VideoType;
 	off64_t newsize = size;
 
 	if (minfo->bookmarks.start != 0)
@@ -464,16 +510,20 @@ bool CMovieCut::cutMovie(MI_MOVIE_INFO *minfo)
 				goto ret_err;
 			}
 			size_t toread = (until - offset) > BUF_SIZE ? BUF_SIZE : until - offset;
-			size_t r = read(srcfd, buf, toread);
+			ssize_t r;
+			if (need_gop)
+				r = read(srcfd, buf, toread);
+			else
+				r = copy_data(srcfd, dstfd, buf, toread, zerocopy);
 			if (r > 0)
 			{
 				int wptr = 0;
-				if (r != toread)
-					printf("CMovieCut::%s: short read at %" PRId64 ": %d\n", __func__, offset, (int)r);
-				if (buf[0] != 0x47)
-					printf("CMovieCut::%s: buffer not aligned at %" PRId64 "\n", __func__, offset);
 				if (need_gop)
 				{
+					if ((size_t)r != toread)
+						printf("CMovieCut::%s: short read at %" PRId64 ": %d\n", __func__, offset, (int)r);
+					if (buf[0] != 0x47)
+						printf("CMovieCut::%s: buffer not aligned at %" PRId64 "\n", __func__, offset);
 					int gop = find_gop(buf, r);
 					if (gop >= 0)
 					{
@@ -484,17 +534,22 @@ bool CMovieCut::cutMovie(MI_MOVIE_INFO *minfo)
 					else
 						printf("CMovieCut::%s: GOP not found\n", __func__);
 					need_gop = 0;
+					ssize_t wr = write(dstfd, &buf[wptr], r - wptr);
+					if (wr < (r - wptr))
+					{
+						perror(dpart);
+						goto ret_err;
+					}
 				}
 				offset += r;
 				spos += r - wptr;
 				percent = (int)((float)(spos) / (float)(newsize) * 100.);
 				paintProgress(msg != 0);
-				size_t wr = write(dstfd, &buf[wptr], r - wptr);
-				if (wr < (r - wptr))
-				{
-					perror(dpart);
-					goto ret_err;
-				}
+			}
+			else if (r < 0)
+			{
+				perror(dpart);
+				goto ret_err;
 			}
 			else if (offset < s.st_size)
 			{
@@ -562,10 +617,12 @@ bool CMovieCut::copyMovie(MI_MOVIE_INFO *minfo, bool onefile)
 	bool dst_done = 0;
 	bool was_cancel = false;
 	bool retval = false;
+	bool zerocopy = true;
 	int bcount = 0;
 	off64_t newsize = 0;
 
 	off64_t secsize = getSecondSize(minfo);
+	vtype = minfo->VideoType;
 	for (int book_nr = 0; book_nr < MI_MOVIE_BOOK_USER_MAX; book_nr++)
 	{
 		if (minfo->bookmarks.user[book_nr].pos != 0 && minfo->bookmarks.user[book_nr].length > 0)
@@ -641,16 +698,20 @@ bool CMovieCut::copyMovie(MI_MOVIE_INFO *minfo, bool onefile)
 				retval = true;
 				goto ret_err;
 			}
-			size_t r = read(srcfd, buf, toread);
+			ssize_t r;
+			if (need_gop)
+				r = read(srcfd, buf, toread);
+			else
+				r = copy_data(srcfd, dstfd, buf, toread, zerocopy);
 			if (r > 0)
 			{
 				int wptr = 0;
-				if (r != toread)
-					printf("****** short read ? %d\n", (int)r);
-				if (buf[0] != 0x47)
-					printf("copy: buffer not aligned at %" PRId64 "\n", offset);
 				if (need_gop)
 				{
+					if ((size_t)r != toread)
+						printf("****** short read ? %d\n", (int)r);
+					if (buf[0] != 0x47)
+						printf("copy: buffer not aligned at %" PRId64 "\n", offset);
 					int gop = find_gop(buf, r);
 					if (gop >= 0)
 					{
@@ -661,20 +722,26 @@ bool CMovieCut::copyMovie(MI_MOVIE_INFO *minfo, bool onefile)
 					else
 						printf("cut: GOP needed, but not found\n");
 					need_gop = 0;
+
+					ssize_t wr = write(dstfd, &buf[wptr], r - wptr);
+					if (wr < (r - wptr))
+					{
+						printf("write to %s failed\n", dpart);
+						unlink(dpart);
+						goto ret_err;
+					}
 				}
 				offset += r;
 				spos += r - wptr;
 				btotal += r;
 				percent = (int)((float)(btotal) / (float)(newsize) * 100.);
 				paintProgress(msg != 0);
-
-				size_t wr = write(dstfd, &buf[wptr], r - wptr);
-				if (wr < (r - wptr))
-				{
-					printf("write to %s failed\n", dpart);
-					unlink(dpart);
-					goto ret_err;
-				}
+			}
+			else if (r < 0)
+			{
+				printf("copy to %s failed\n", dpart);
+				unlink(dpart);
+				goto ret_err;
 			}
 			else if (offset < s.st_size)
 			{
@@ -32,6 +32,7 @@ class CMovieCut
 		int x;
 		int y;
 		int percent;
+		int vtype;
 
 		void reset_atime(const char *path, time_t tt);
 		uint32_t getHeaderDurationMS(MI_MOVIE_INFO *minfo);
@@ -39,6 +40,7 @@ class CMovieCut
 		void WriteHeader(const char *path, uint32_t duration);
 		int check_pes_start(unsigned char *packet);
 		int find_gop(unsigned char *buf, int r);
+		ssize_t copy_data(int srcfd, int dstfd, unsigned char *buf, size_t size, bool &zerocopy);
 		off64_t fake_read(int fd, unsigned char *buf, size_t size, off64_t fsize);
 		int read_psi(const char *spart, unsigned char *buf);
 		void save_info(MI_MOVIE_INFO *minfo, char *dpart, off64_t spos, off64_t secsize);
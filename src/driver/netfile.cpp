@@ -108,6 +108,7 @@
 #include <poll.h>
 #include <sys/types.h>
 #include <driver/audioplay.h>
+#include <driver/abstime.h>
 #include <system/set_threadname.h>
 /*
 TODO:
@@ -941,21 +942,14 @@ FILE *f_open(const char *filename, const char *acctype)
 							cache[i].closed   = 0;
 							cache[i].total_bytes_delivered = 0;
 							cache[i].filter   = NULL;
-
-							/* create the readable/writeable mutex locks */
-							dprintf(stderr, "f_open: creating mutexes\n");
-							pthread_mutex_init(&cache[i].cache_lock, &cache[i].cache_lock_attr);
-							pthread_mutex_init(&cache[i].readable,   &cache[i].readable_attr);
-							pthread_mutex_init(&cache[i].writeable,  &cache[i].writeable_attr);
-
-							/* and set the empty cache to 'unreadable' */
-							dprintf(stderr, "f_open: locking read direction\n");
-							pthread_mutex_lock( &cache[i].readable );
-
-							/* but writeable. */
-//							dprintf(stderr, "f_open: unlocking write direction\n");
-// mutex is not locked after init
-//							pthread_mutex_unlock( &cache[i].writeable );
+							cache[i].start_ms = 0;
+							cache[i].bytes_in = 0;
+							cache[i].prefill  = 1;
+
+							dprintf(stderr, "f_open: creating cache lock\n");
+							pthread_mutex_init(&cache[i].cache_lock, NULL);
+							pthread_cond_init(&cache[i].readable, NULL);
+							pthread_cond_init(&cache[i].writeable, NULL);
 						}
 
 						/* send the file request and check it'S revurn value */
@@ -1188,11 +1182,11 @@ int f_close(FILE *stream)
 	{
 		dprintf(stderr, "f_close: removing stream %p from cache[%d]\n", stream, i);
 
-		cache[i].closed = 1;		/* indicate that the cache is closed */
-
-		/* remove the cache looks */
-		pthread_mutex_unlock( &cache[i].writeable );
-		pthread_mutex_unlock( &cache[i].readable );
+		/* indicate that the cache is closed and wake up push()/pop() */
+		pthread_mutex_lock( &cache[i].cache_lock );
+		cache[i].closed = 1;
+		pthread_cond_broadcast( &cache[i].writeable );
+		pthread_cond_broadcast( &cache[i].readable );
 		pthread_mutex_unlock( &cache[i].cache_lock );
 
 		/* wait for the fill thread to finish */
@@ -1215,10 +1209,10 @@ int f_close(FILE *stream)
 				free(cache[i].filter_arg);
 			}
 
-		dprintf(stderr, "f_close: destroying mutexes\n");
+		dprintf(stderr, "f_close: destroying cache lock\n");
 		pthread_mutex_destroy(&cache[i].cache_lock);
-		pthread_mutex_destroy(&cache[i].readable);
-		pthread_mutex_destroy(&cache[i].writeable);
+		pthread_cond_destroy(&cache[i].readable);
+		pthread_cond_destroy(&cache[i].writeable);
 
 		/* completely blank out all data */
 		memset(&cache[i], 0, sizeof(STREAM_CACHE));
@@ -1393,224 +1387,179 @@ int getCacheSlot(FILE *fd)
 	return (i == CACHEENTMAX) ? -1 : i;
 }
 
+/* number of bytes pop() waits for before it starts delivering data:
+ * CACHEPREFILL_MS at the measured input bitrate, at most half the cache */
+static long prefill_bytes(STREAM_CACHE *c)
+{
+	long want = c->csize / 8;
+	int64_t elapsed = time_monotonic_ms() - c->start_ms;
+
+	if (c->start_ms && elapsed > 500)
+		want = (long)(c->bytes_in * CACHEPREFILL_MS / elapsed);
+	if (want < CACHEBTRANS)
+		want = CACHEBTRANS;
+	if (want > c->csize / 2)
+		want = c->csize / 2;
+	return want;
+}
+
 /* push a block of data into the stream cache */
+/* single producer: only the fill thread moves wptr, so the data is */
+/* copied without holding the lock */
 int push(FILE *fd, char *buf, long len)
 {
-	int rval = 0, i, j;
-	int blen = 0;
+	int rval = 0, i;
 
 	i = getCacheSlot(fd);
 
 	if(i < 0)
 		return -1;
 
-	//	dprintf(stderr, "push: %d bytes to store [filled: %d of %d], stream: %x\n", len, cache[i].filled, CACHESIZE, fd);
+	STREAM_CACHE *c = &cache[i];
 
-	if(cache[i].fd != fd) {
+	if(c->fd != fd) {
 		dprintf(stderr, "push: no cache present for stream %p\n", fd);
 		return -1;
 	}
-	do
-	{
-		if(cache[i].closed)
-			return -1;
-
-		/* try to obtain write permissions for the cache */
-		/* this will block if the cache is full */
-		pthread_mutex_lock( &cache[i].writeable );
 
-		if((cache[i].csize - cache[i].filled))
-		{
-			int amt[2];
+	pthread_mutex_lock( &c->cache_lock );
+	if (!c->start_ms)
+		c->start_ms = time_monotonic_ms();
+	pthread_mutex_unlock( &c->cache_lock );
 
-			/* prevent any modification to the cache by other threads, */
-			/* mainly by the pop() function, while we write data to it */
-			pthread_mutex_lock( &cache[i].cache_lock );
-
-			/* has the cache been closed while we were waiting for the */
-			/* lock to open ? */
-			if(cache[i].closed)
-				return -1;
-
-			/* block transfer length: get either what's there or */
-			/* only as much as we need */
-			blen = ((len - rval) > (cache[i].csize - cache[i].filled)) ? (cache[i].csize - cache[i].filled) : (len - rval);
-
-			if(cache[i].wptr < cache[i].rptr)
-			{
-				amt[0] = cache[i].rptr - cache[i].wptr;
-				amt[1] = 0;
-			}
-			else
-			{
-				amt[0] = cache[i].ceiling - cache[i].wptr;
-				amt[1] = cache[i].rptr - cache[i].cache;
-			}
-
-			for(j=0; j<2; j++)
-			{
-				if(amt[j] > blen)
-					amt[j] = blen;
-
-				if(amt[j] > 0)
-				{
-					memmove(cache[i].wptr, buf, amt[j]);
-					cache[i].wptr = cache[i].cache +
-						(((int)(cache[i].wptr - cache[i].cache) + amt[j]) % cache[i].csize);
-
-					buf += amt[j];	/* adjust the target buffer pointer */
-					rval += amt[j];	/* increase the 'total bytes' counter */
-					blen -= amt[j];	/* decrease the block length counter */
-					cache[i].filled += amt[j];
-				}
-			}
-
-			//	dprintf(stderr, "push: %d/%d bytes written [filled: %d of %d], stream: %x\n", amt[0] + amt[1], rval, cache[i].filled, CACHESIZE, fd);
-
-			pthread_mutex_unlock( &cache[i].cache_lock );
-
-			/* unlock the cache for read access, if it */
-			/* contains some data */
-			if(cache[i].filled){
-				pthread_mutex_unlock( &cache[i].readable );
-			}
-		}
-
-		/* if there is still space in the cache, unlock */
-		/* it again for further writing by anyone */
-		if(cache[i].csize - cache[i].filled){
-			pthread_mutex_unlock( & cache[i].writeable );
+	while(rval < len)
+	{
+		/* wait for free space */
+		pthread_mutex_lock( &c->cache_lock );
+		while(!c->closed && (c->filled == c->csize))
+			pthread_cond_wait( &c->writeable, &c->cache_lock );
+		if(c->closed) {
+			pthread_mutex_unlock( &c->cache_lock );
+			return -1;
 		}
-		else
-			dprintf(stderr, "push: buffer overrun; cache full - leaving cache locked\n");
-
-	} while(rval < len);
+		long space = c->csize - c->filled;
+		char *wptr = c->wptr;
+		pthread_mutex_unlock( &c->cache_lock );
+
+		/* contiguous part up to the ceiling, the rest in the next round */
+		long amt = len - rval;
+		if(amt > space)
+			amt = space;
+		if(amt > c->ceiling - wptr)
+			amt = c->ceiling - wptr;
+		memmove(wptr, buf, amt);
+
+		pthread_mutex_lock( &c->cache_lock );
+		c->wptr = c->cache + ((wptr - c->cache + amt) % c->csize);
+		c->filled += amt;
+		c->bytes_in += amt;
+		pthread_cond_signal( &c->readable );
+		pthread_mutex_unlock( &c->cache_lock );
+
+		buf += amt;
+		rval += amt;
+	}
 
-	dprintf(stderr, "push: exitstate: [filled: %3.1f %%], stream: %p\r", 100.0 * (float)cache[i].filled / (float)cache[i].csize, fd);
+	dprintf(stderr, "push: exitstate: [filled: %3.1f %%], stream: %p\r", 100.0 * (float)c->filled / (float)c->csize, fd);
 
 	return rval;
 }
 
+/* wait at most 100ms for push(), called with cache_lock held */
+static void wait_readable(STREAM_CACHE *c)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_nsec += 100 * 1000000;
+	if(ts.tv_nsec >= 1000000000) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+	pthread_cond_timedwait( &c->readable, &c->cache_lock, &ts );
+}
+
+/* single consumer: only pop() moves rptr */
 int pop(FILE *fd, char *buf, long len)
 {
-	int rval = 0, i, j;
-	int blen = 0;
+	int rval = 0, i;
 
 	i = getCacheSlot(fd);
 
 	if(i < 0)
 		return -1;
 
+	STREAM_CACHE *c = &cache[i];
+
 	dprintf(stderr, "pop: %d bytes requested [filled: %d of %d], stream: %p buf %p\n",
-		(int) len, (int) cache[i].filled, (int) CACHESIZE, fd, buf);
+		(int) len, (int) c->filled, (int) CACHESIZE, fd, buf);
 
-	if(cache[i].fd == fd)
+	if(c->fd != fd)
 	{
-		do
-		{
-			if(cache[i].closed && (!cache[i].filled) )
-				return 0;
+		dprintf(stderr, "pop: no cache present for stream %p\n", fd);
+		return -1;
+	}
 
-			if((!cache[i].filled) && feof(fd)){
-				return 0;
-			}
+	while((rval < len) && (CAudioPlayer::getInstance()->getState() != CBaseDec::STOP_REQ))
+	{
+		pthread_mutex_lock( &c->cache_lock );
 
-			/* try to obtain read permissions for the cache */
-			/* this will block if the cache is empty */
-#if 0 //FIXME no way to stop if connection dead ?
-			pthread_mutex_lock( & cache[i].readable );
-#else
-			while(true) {
-				int lret = pthread_mutex_trylock(&cache[i].readable);
-				if((lret == 0) || (CAudioPlayer::getInstance()->getState() == CBaseDec::STOP_REQ))
-					break;
-				usleep(100);
-			}
-#endif
-			if(cache[i].filled)
+		/* at start and after an underrun, buffer some playtime first */
+		if(c->prefill)
+		{
+			int64_t until = time_monotonic_ms() + CACHEPREFILL_WAIT;
+			long want = prefill_bytes(c);
+			while(!c->closed && (c->filled < want) && (time_monotonic_ms() < until)
+					&& (CAudioPlayer::getInstance()->getState() != CBaseDec::STOP_REQ))
 			{
-				int amt[2];
-
-				/* prevent any modification to the cache by other threads, */
-				/* mainly by the push() function, while we read data from it */
-				pthread_mutex_lock( &cache[i].cache_lock );
-
-				/* block transfer length: get either what's there or */
-				/* only as much as we need */
-				blen = ((len - rval) > cache[i].filled) ? cache[i].filled : (len - rval);
-
-				if(cache[i].rptr < cache[i].wptr)
-				{
-					amt[0] = cache[i].wptr - cache[i].rptr;
-					amt[1] = 0;
-				}
-				else
-				{
-					amt[0] = cache[i].ceiling - cache[i].rptr;
-					amt[1] = cache[i].wptr - cache[i].cache;
-				}
-
-				for(j=0; j<2; j++)
-				{
-					if(amt[j] > blen) amt[j] = blen;
-
-					if(amt[j])
-					{
-						dprintf(stderr, "pop(): rptr: %p, buf: %p, amt[%d]=%d, blen=%d, len=%d, rval=%d\n",
-							cache[i].rptr, buf, j, amt[j], blen, (int) len, rval);
-
-						memmove(buf, cache[i].rptr, amt[j]);
-
-						cache[i].rptr = cache[i].cache +
-							(((int)(cache[i].rptr - cache[i].cache) + amt[j]) % cache[i].csize);
-
-						buf += amt[j];	/* adjust the target buffer pointer */
-						rval += amt[j];	/* increase the 'total bytes' counter */
-						blen -= amt[j];	/* decrease the block length counter */
-						cache[i].filled -= amt[j];
-					}
-				}
-
-				dprintf(stderr, "pop: %d/%d/%d bytes read [filled: %d of %d], stream: %p\n", amt[0] + amt[1], rval, (int) len, (int) cache[i].filled, (int) CACHESIZE, fd);
-
-				/* if the cache is closed and empty, then */
-				/* force the end condition to be met */
-				if(cache[i].closed && (! cache[i].filled))
-					break;//len = rval;
-
-				/* allow write access again */
-				pthread_mutex_unlock( &cache[i].cache_lock );
-
-				/* unlock the cache for write access, if it */
-				/* has some free space */
-				if(cache[i].csize - cache[i].filled){
-					pthread_mutex_unlock( &cache[i].writeable );
-				}
+				wait_readable(c);
+				want = prefill_bytes(c);
 			}
+			dprintf(stderr, "pop: prefill %ld of %ld bytes\n", c->filled, want);
+			c->prefill = 0;
+		}
 
-			/* if there is still data in the cache, unlock */
-			/* it again for further reading by anyone */
-			if(cache[i].filled)
-			{
-				pthread_mutex_unlock( & cache[i].readable );
-			}
-			else
-				dprintf(stderr, "pop: buffer underrun; cache empty - leaving cache locked\n");
-		} while((rval < len) && (CAudioPlayer::getInstance()->getState() != CBaseDec::STOP_REQ));
-	}
-	else
-	{
-		dprintf(stderr, "pop: no cache present for stream %p\n", fd);
-		rval = -1;
+		/* wait for data, check for stop every 100ms */
+		while(!c->filled && !c->closed && !feof(fd)
+				&& (CAudioPlayer::getInstance()->getState() != CBaseDec::STOP_REQ))
+			wait_readable(c);
+		if(!c->filled)
+		{
+			/* closed, eof or stopped */
+			pthread_mutex_unlock( &c->cache_lock );
+			break;
+		}
+		long avail = c->filled;
+		char *rptr = c->rptr;
+		pthread_mutex_unlock( &c->cache_lock );
+
+		long amt = len - rval;
+		if(amt > avail)
+			amt = avail;
+		if(amt > c->ceiling - rptr)
+			amt = c->ceiling - rptr;
+		memmove(buf, rptr, amt);
+
+		pthread_mutex_lock( &c->cache_lock );
+		c->rptr = c->cache + ((rptr - c->cache + amt) % c->csize);
+		c->filled -= amt;
+		if(!c->filled && !c->closed) {
+			dprintf(stderr, "pop: buffer underrun; cache empty\n");
+			c->prefill = 1;
+		}
+		pthread_cond_signal( &c->writeable );
+		pthread_mutex_unlock( &c->cache_lock );
+
+		buf += amt;
+		rval += amt;
 	}
 
-//  dprintf(stderr, "pop:  exitstate: [filled: %3.1f %%], stream: %x\n", 100.0 * (float)cache[i].filled / (float)cache[i].csize, fd);
+	dprintf(stderr, "pop: %d/%d bytes read [filled: %d of %d], stream: %p\n", rval, (int) len, (int) c->filled, (int) CACHESIZE, fd);
 
-	cache[i].total_bytes_delivered += rval;
+	c->total_bytes_delivered += rval;
 
-	if(cache[i].filter_arg)
-		if(cache[i].filter_arg->state)
-			cache[i].filter_arg->state->buffered = 65536L * (int64_t)cache[i].filled / (int64_t)CACHESIZE;
+	if(c->filter_arg)
+		if(c->filter_arg->state)
+			c->filter_arg->state->buffered = 65536L * (int64_t)c->filled / (int64_t)CACHESIZE;
 
 	return rval;
 }
@@ -1794,9 +1743,11 @@ void *CacheFillThread(void *c)
 	//while( (rval == datalen) && (!scache->closed) );
 
 	/* close the cache if the stream disrupted */
+	pthread_mutex_lock( &scache->cache_lock );
 	scache->closed = 1;
-	pthread_mutex_unlock( &scache->writeable );
-	pthread_mutex_unlock( &scache->readable );
+	pthread_cond_broadcast( &scache->writeable );
+	pthread_cond_broadcast( &scache->readable );
+	pthread_mutex_unlock( &scache->cache_lock );
 
 	/* ... and exit this thread. */
 	dprintf(stderr, "CacheFillThread: thread exited, stream %p  \n", scache->fd);
@@ -41,6 +41,7 @@ extern "C" {
 #include <errno.h>
 #include <ctype.h>
 #include <pthread.h>
+#include <stdint.h>
 
 #define dprintf if(debug) fprintf
 
@@ -90,6 +91,8 @@ extern char err_txt[32818];
 #define CACHESIZE	cache_size
 #define CACHEENTMAX	20	/* at most 20 caches are available */
 #define CACHEBTRANS	1024	/* blocksize for the stream-to-cache transfer */
+#define CACHEPREFILL_MS	1500	/* buffer this much playtime before reading starts */
+#define CACHEPREFILL_WAIT 3000	/* but wait at most this long (ms) for it */
 
 typedef struct
 {
@@ -159,14 +162,16 @@ typedef struct
 
 	pthread_t fill_thread;
 	pthread_attr_t attr;
+	/* protects rptr, wptr, filled and closed; the data itself is
+	 * copied outside the lock, push() and pop() never touch the
+	 * same part of the buffer */
 	pthread_mutex_t cache_lock;
-	pthread_mutexattr_t cache_lock_attr;
+	pthread_cond_t readable;	/* signalled when data was pushed */
+	pthread_cond_t writeable;	/* signalled when data was popped */
 
-	pthread_mutex_t readable;
-	pthread_mutexattr_t readable_attr;
-
-	pthread_mutex_t writeable;
-	pthread_mutexattr_t writeable_attr;
+	int64_t	start_ms;		/* time of the first push */
+	long long bytes_in;		/* bytes pushed, for the bitrate */
+	int	prefill;		/* 1: wait for CACHEPREFILL_MS of data before pop */
 
 	void (*filter)(STREAM_FILTER*);	/* stream filter function */
 
@@ -36,6 +36,7 @@
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <sys/inotify.h>
 #include <linux/input.h>
 #include <utime.h>
 #include <stdlib.h>
@@ -145,6 +146,17 @@ CRCInput::CRCInput()
 		perror("[neutrino] listen failed...\n");
 		exit( -1 );
 	}
+	/* watch /dev/input for hot-plugged devices, fall back to
+	   stat()ing the directory in getMsg_us if this fails */
+	fd_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd_inotify < 0)
+		perror("[neutrino] inotify_init1");
+	else if (inotify_add_watch(fd_inotify, "/dev/input", IN_CREATE | IN_DELETE | IN_ATTRIB) < 0) {
+		perror("[neutrino] inotify_add_watch /dev/input");
+		::close(fd_inotify);
+		fd_inotify = -1;
+	}
+
 	repeat_block = repeat_block_generic = 0;
 	checkdev();
 	open();
@@ -176,6 +188,18 @@ bool CRCInput::checkdev()
 	return true; /* need to check anyway... */
 }
 
+/* drain pending inotify events, returns true if /dev/input changed */
+bool CRCInput::checkinotify()
+{
+	char buf[sizeof(struct inotify_event) + NAME_MAX + 1] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	bool changed = false;
+	while (read(fd_inotify, buf, sizeof(buf)) > 0)
+		changed = true;
+	if (changed)
+		printf("[rcinput:%s] /dev/input changed\n", __func__);
+	return changed;
+}
+
 bool CRCInput::checkpath(in_dev id)
 {
 	for (std::vector<in_dev>::iterator it = indev.begin(); it != indev.end(); ++it) {
@@ -336,6 +360,8 @@ void CRCInput::calculateMaxFd()
 		fd_max = fd_pipe_high_priority[0];
 	if(fd_pipe_low_priority[0] > fd_max)
 		fd_max = fd_pipe_low_priority[0];
+	if(fd_inotify > fd_max)
+		fd_max = fd_inotify;
 }
 
 /**************************************************************************
@@ -358,6 +384,9 @@ CRCInput::~CRCInput()
 
 	if(fd_event)
 		::close(fd_event);
+
+	if(fd_inotify >= 0)
+		::close(fd_inotify);
 }
 
 /**************************************************************************
@@ -635,10 +664,9 @@ void CRCInput::getMsg_us(neutrino_msg_t * msg, neutrino_msg_data_t * data, uint6
 
 	*data = 0;
 
-	/* reopen a missing input device
-	 * TODO: real hot-plugging, e.g. of keyboards and triggering this loop...
-	 *       right now it is only run if some event is happening "by accident" */
-	if (!input_stopped) {
+	/* reopen a missing input device. With inotify, new devices are
+	 * picked up in the select loop below as soon as they appear */
+	if (!input_stopped && fd_inotify < 0) {
 		if (checkdev())
 			open(true);
 	}
@@ -648,10 +676,16 @@ void CRCInput::getMsg_us(neutrino_msg_t * msg, neutrino_msg_data_t * data, uint6
 
 	while(1) {
 		timer_id = 0;
-		if ( !timers.empty() )
+		/* timers are sorted by timeout, only the first one is of interest */
+		timer_mutex.lock();
+		bool have_timer = !timers.empty();
+		uint64_t next_times_out = have_timer ? timers[0].times_out : 0;
+		uint32_t next_id = have_timer ? timers[0].id : 0;
+		timer_mutex.unlock();
+		if (have_timer)
 		{
 			uint64_t t_n = time_monotonic_us();
-			if ( timers[0].times_out< t_n )
+			if ( next_times_out< t_n )
 			{
 				timer_id = checkTimers();
 				*msg = NeutrinoMessages::EVT_TIMER;
@@ -660,11 +694,11 @@ void CRCInput::getMsg_us(neutrino_msg_t * msg, neutrino_msg_data_t * data, uint6
 			}
 			else
 			{
-				targetTimeout = timers[0].times_out - t_n;
+				targetTimeout = next_times_out - t_n;
 				if ( (uint64_t) targetTimeout> Timeout)
 					targetTimeout= Timeout;
 				else
-					timer_id = timers[0].id;
+					timer_id = next_id;
 			}
 		}
 		else
@@ -689,6 +723,8 @@ void CRCInput::getMsg_us(neutrino_msg_t * msg, neutrino_msg_data_t * data, uint6
 		FD_SET(fd_event, &rfds);
 		FD_SET(fd_pipe_high_priority[0], &rfds);
 		FD_SET(fd_pipe_low_priority[0], &rfds);
+		if (fd_inotify >= 0)
+			FD_SET(fd_inotify, &rfds);
 
 		int status =  select(fd_max+1, &rfds, NULL, NULL, &tvselect);
 
@@ -736,6 +772,11 @@ void CRCInput::getMsg_us(neutrino_msg_t * msg, neutrino_msg_data_t * data, uint6
 			return;
 		}
 
+		if (fd_inotify >= 0 && FD_ISSET(fd_inotify, &rfds)) {
+			if (checkinotify() && !input_stopped)
+				open(true);
+		}
+
 
 #ifdef KEYBOARD_INSTEAD_OF_REMOTE_CONTROL
 		if (FD_ISSET(fd_keyb, &rfds))
@@ -1448,6 +1489,7 @@ void CRCInput::getMsg_us(neutrino_msg_t * msg, neutrino_msg_data_t * data, uint6
 #endif
 						{
 							last_keypress = now_pressed;
+							d_printf("key %04x dispatch latency %" PRId64 " us\n", trkey, (int64_t)(time_monotonic_us() - now_pressed));
 
 							*msg = trkey;
 							*data = 0; /* <- button pressed */
@@ -90,6 +90,7 @@ class CRCInput
 		std::vector<in_dev> indev;
 		int fd_keyb;
 		int fd_event;
+		int fd_inotify;
 		int fd_max;
 		__u16 rc_last_key;
 		OpenThreads::Mutex mutex;
@@ -98,6 +99,7 @@ class CRCInput
 		void open(bool recheck = false);
 		bool checkpath(in_dev id);
 		bool checkdev();
+		bool checkinotify();
 		void close();
 		int translate(int code);
 		int translate_revert(int code);
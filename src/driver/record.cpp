@@ -51,6 +51,7 @@
 
 #include <driver/display.h>
 #include <driver/record.h>
+#include <driver/recordsync.h>
 #include <driver/radiotext.h>
 #include <driver/streamts.h>
 #include <driver/abstime.h>
@@ -150,6 +151,7 @@ CRecordInstance::CRecordInstance(const CTimerd::RecordingInfo * const eventinfo,
 	cMovieInfo = new CMovieInfo();
 	recMovieInfo = new MI_MOVIE_INFO();
 	record = NULL;
+	record_fd = -1;
 	rec_stop_msg = g_Locale->getText(LOCALE_RECORDING_STOP);
 }
 
@@ -159,6 +161,8 @@ CRecordInstance::~CRecordInstance()
 	recMovieInfo->audioPids.clear();
 	delete recMovieInfo;
 	delete cMovieInfo;
+	if (record_fd >= 0)
+		CRecordSync::getInstance()->Remove(record_fd);
 	delete record;
 }
 
@@ -407,7 +411,8 @@ record_error_msg_t CRecordInstance::Start(CZapitChannel * channel)
 	std::string tsfile = std::string(filename) + ".ts";
 	printf("%s: file %s vpid %x apid %x\n", __FUNCTION__, tsfile.c_str(), allpids.PIDs.vpid, apids[0]);
 
-	int fd = open(tsfile.c_str(), O_CREAT | O_TRUNC | O_SYNC | O_RDWR | O_LARGEFILE | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	/* no O_SYNC, CRecordSync bounds the unwritten data */
+	int fd = open(tsfile.c_str(), O_CREAT | O_TRUNC | O_RDWR | O_LARGEFILE | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
 	if(fd < 0) {
 		perror(tsfile.c_str());
 		hintBox.hide();
@@ -449,6 +454,9 @@ record_error_msg_t CRecordInstance::Start(CZapitChannel * channel)
 		hintBox.hide();
 		return RECORD_FAILURE;
 	}
+	record_fd = fd;
+	/* timeshift is read back right away, keep it in cache */
+	CRecordSync::getInstance()->Add(record_fd, !autoshift);
 
 	printf("CRecordInstance::Start: fe %d demux %d\n", frontend->getNumber(), channel->getRecordDemux());
 	if(!autoshift)
@@ -487,9 +495,14 @@ bool CRecordInstance::Stop(bool remove_event)
 	printf("%s: channel %" PRIx64 " recording_id %d\n", __func__, channel_id, recording_id);
 	printf("%s: file %s.ts\n", __FUNCTION__, filename);
 	SaveXml();
-	/* Stop do close fd - if started */
+	if (record_fd >= 0) {
+		CRecordSync::getInstance()->Remove(record_fd);
+		record_fd = -1;
+	}
 	/* Stop do close fd - if started */
 	record->Stop();
+	snprintf(buf, sizeof(buf), "%s.ts", filename);
+	CRecordSync::Trim(buf);
 
 	CCamManager::getInstance()->Stop(channel_id, CCamManager::RECORD);
 
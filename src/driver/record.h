@@ -108,6 +108,7 @@ class CRecordInstance
 		CMovieInfo *	cMovieInfo;
 		MI_MOVIE_INFO *	recMovieInfo;
 		cRecord *	record;
+		int		record_fd;
 
 		virtual void GetPids(CZapitChannel * channel);
 		virtual void FillMovieInfo(CZapitChannel * channel, APIDList & apid_list);
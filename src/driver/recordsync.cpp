@@ -0,0 +1,188 @@
+/*
+	Neutrino-GUI  -   DBoxII-Project
+
+	Background writeback of recording files
+
+	License: GPLv2
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation;
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include <driver/recordsync.h>
+#include <system/set_threadname.h>
+
+CRecordSync * CRecordSync::instance = NULL;
+
+CRecordSync::CRecordSync()
+{
+	running = false;
+	pthread_mutex_init(&mutex, NULL);
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&cond, &attr);
+	pthread_condattr_destroy(&attr);
+	pthread_cond_init(&idle_cond, NULL);
+}
+
+CRecordSync::~CRecordSync()
+{
+	pthread_mutex_lock(&mutex);
+	running = false;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+	join();
+	files.clear();
+	pthread_cond_destroy(&idle_cond);
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&mutex);
+}
+
+CRecordSync * CRecordSync::getInstance()
+{
+	if (instance == NULL)
+		instance = new CRecordSync();
+	return instance;
+}
+
+void CRecordSync::Add(int fd, bool drop_cache)
+{
+	sync_state_t state;
+	struct stat st;
+
+	state.synced = 0;
+	state.started = 0;
+	state.allocated = 0;
+	state.passes = 0;
+	state.prealloc = true;
+	state.drop_cache = drop_cache;
+	state.busy = false;
+	if (fstat(fd, &st) == 0)
+		state.allocated = st.st_size;
+
+	pthread_mutex_lock(&mutex);
+	files[fd] = state;
+	if (!running) {
+		running = true;
+		if (start() != 0) {
+			printf("[CRecordSync] %s: start thread failed\n", __func__);
+			running = false;
+		}
+	}
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+}
+
+void CRecordSync::Remove(int fd)
+{
+	/* wait for a running Sync(), fd is not touched after this */
+	pthread_mutex_lock(&mutex);
+	sync_map_t::iterator it = files.find(fd);
+	while (it != files.end() && it->second.busy) {
+		pthread_cond_wait(&idle_cond, &mutex);
+		it = files.find(fd);
+	}
+	if (it != files.end())
+		files.erase(it);
+	pthread_mutex_unlock(&mutex);
+}
+
+void CRecordSync::Trim(const char * file)
+{
+	int fd = open(file, O_WRONLY | O_LARGEFILE | O_CLOEXEC);
+	if (fd < 0)
+		return;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && ftruncate(fd, st.st_size))
+		printf("[CRecordSync] %s: ftruncate %s failed: %m\n", __func__, file);
+	close(fd);
+}
+
+/* called unlocked with state.busy set, Remove() waits for it */
+void CRecordSync::Sync(int fd, sync_state_t &state)
+{
+	struct stat st;
+	if (fstat(fd, &st))
+		return;
+	off_t size = st.st_size;
+
+	if (state.prealloc && (size + RECORD_PREALLOC / 2 > state.allocated)) {
+		off_t from = (size > state.allocated) ? size : state.allocated;
+		if (fallocate(fd, FALLOC_FL_KEEP_SIZE, from, RECORD_PREALLOC) == 0)
+			state.allocated = from + RECORD_PREALLOC;
+		else
+			state.prealloc = false;	/* not supported, e.g. nfs or vfat */
+	}
+
+	/* writeback started one pass ago should be done by now */
+	if (state.started > state.synced) {
+		off_t len = state.started - state.synced;
+		sync_file_range(fd, state.synced, len, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+		if (state.drop_cache)
+			posix_fadvise(fd, state.synced, len, POSIX_FADV_DONTNEED);
+		state.synced = state.started;
+	}
+
+	/* sync_file_range() writes no metadata, the size and the preallocated
+	 * extents written into are only committed by fdatasync() */
+	if (++state.passes >= RECORD_SYNC_METADATA && size > 0) {
+		fdatasync(fd);
+		state.passes = 0;
+	}
+
+	/* start writeback of data written since last pass */
+	if (size > state.started) {
+		sync_file_range(fd, state.started, size - state.started, SYNC_FILE_RANGE_WRITE);
+		state.started = size;
+	}
+}
+
+void CRecordSync::run()
+{
+	set_threadname("n:recordsync");
+	pthread_mutex_lock(&mutex);
+	while (running) {
+		if (files.empty()) {
+			pthread_cond_wait(&cond, &mutex);
+			continue;
+		}
+		struct timespec abs;
+		clock_gettime(CLOCK_MONOTONIC, &abs);
+		abs.tv_sec += RECORD_SYNC_INTERVAL;
+		while (running && pthread_cond_timedwait(&cond, &mutex, &abs) == 0)
+			;
+		/* the disk i/o runs unlocked, so Add() and Remove() of other
+		 * recordings don't wait for it. a busy entry is never erased,
+		 * so the iterator stays valid */
+		for (sync_map_t::iterator it = files.begin(); running && it != files.end(); ++it) {
+			it->second.busy = true;
+			pthread_mutex_unlock(&mutex);
+			Sync(it->first, it->second);
+			pthread_mutex_lock(&mutex);
+			it->second.busy = false;
+			pthread_cond_broadcast(&idle_cond);
+		}
+	}
+	pthread_mutex_unlock(&mutex);
+}
@@ -0,0 +1,82 @@
+/*
+	Neutrino-GUI  -   DBoxII-Project
+
+	Background writeback of recording files
+
+	License: GPLv2
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation;
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef __recordsync_h__
+#define __recordsync_h__
+
+#include <sys/types.h>
+#include <pthread.h>
+#include <map>
+
+#include <OpenThreads/Thread>
+
+/* seconds between writeback passes */
+#define RECORD_SYNC_INTERVAL	2
+/* passes between fdatasync(), which commits file size and extents. a crash
+ * loses at most (RECORD_SYNC_METADATA + 1) * RECORD_SYNC_INTERVAL seconds */
+#define RECORD_SYNC_METADATA	5
+/* preallocation step for recording files */
+#define RECORD_PREALLOC		(64 * 1024 * 1024)
+
+/*
+ * Recording files are written without O_SYNC by the record library. This
+ * thread bounds the amount of dirty data per file with sync_file_range(),
+ * preallocates the files in big extents and drops written data from the
+ * page cache, so recordings don't evict everything else.
+ */
+class CRecordSync : public OpenThreads::Thread
+{
+	private:
+		typedef struct {
+			off_t synced;		/* on disk, dropped from cache */
+			off_t started;		/* writeback started */
+			off_t allocated;	/* preallocated up to */
+			int passes;		/* since last fdatasync() */
+			bool prealloc;
+			bool drop_cache;
+			bool busy;		/* Sync() running, Remove() waits */
+		} sync_state_t;
+		typedef std::map<int, sync_state_t> sync_map_t;
+
+		static CRecordSync * instance;
+
+		sync_map_t files;
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
+		pthread_cond_t idle_cond;
+		bool running;
+
+		CRecordSync();
+		void run();
+		void Sync(int fd, sync_state_t &state);
+	public:
+		~CRecordSync();
+		static CRecordSync * getInstance();
+
+		/* start background writeback for fd, drop_cache false for timeshift */
+		void Add(int fd, bool drop_cache);
+		/* stop background writeback, must be called before fd is closed */
+		void Remove(int fd);
+		/* free preallocated space behind the end of a closed file */
+		static void Trim(const char * file);
+};
+
+#endif
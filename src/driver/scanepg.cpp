@@ -38,6 +38,7 @@
 #include <driver/scanepg.h>
 #include <driver/record.h>
 #include <driver/streamts.h>
+#include <driver/abstime.h>
 
 //#define EPG_RESCAN_TIME (24*60*60)
 
@@ -52,6 +53,7 @@ CEpgScan::CEpgScan()
 	standby = false;
 	rescan_timer = 0;
 	scan_in_progress = false;
+	scan_start = 0;
 	Clear();
 }
 
@@ -97,6 +99,7 @@ void CEpgScan::ConfigureEIT()
 void CEpgScan::Clear()
 {
 	scanmap.clear();
+	fav_tps.clear();
 	current_bnum = -1;
 	current_bmode = -1;
 	next_chid = 0;
@@ -109,15 +112,33 @@ bool CEpgScan::Running()
 	return (CheckMode() && !scanmap.empty());
 }
 
-void CEpgScan::AddBouquet(CChannelList * clist)
+void CEpgScan::AddBouquet(CChannelList * clist, bool fav)
 {
 	for (unsigned i = 0; i < clist->Size(); i++) {
 		CZapitChannel * chan = clist->getChannelFromIndex(i);
-		if (!IS_WEBCHAN(chan->getChannelID()) && scanned.find(chan->getTransponderId()) == scanned.end())
+		if (!IS_WEBCHAN(chan->getChannelID()) && scanned.find(chan->getTransponderId()) == scanned.end()) {
 			scanmap.insert(eit_scanmap_pair_t(chan->getTransponderId(), chan->getChannelID()));
+			if (fav)
+				fav_tps.insert(chan->getTransponderId());
+		}
 	}
 }
 
+/* transponders from favorites first, then the one with the oldest EIT data */
+bool CEpgScan::IsBetter(transponder_id_t tp, transponder_id_t best)
+{
+	bool fav = fav_tps.find(tp) != fav_tps.end();
+	bool best_fav = fav_tps.find(best) != fav_tps.end();
+	if (fav != best_fav)
+		return fav;
+
+	eit_scantime_t::iterator it = scan_time.find(tp);
+	time_t age = (it == scan_time.end()) ? 0 : it->second;
+	it = scan_time.find(best);
+	time_t best_age = (it == scan_time.end()) ? 0 : it->second;
+	return age < best_age;
+}
+
 bool CEpgScan::AddFavorites()
 {
 	INFO("allfav_done: %d", allfav_done);
@@ -128,7 +149,7 @@ bool CEpgScan::AddFavorites()
 	unsigned old_size = scanmap.size();
 	for (unsigned j = 0; j < TVfavList->Bouquets.size(); ++j) {
 		CChannelList * clist = TVfavList->Bouquets[j]->channelList;
-		AddBouquet(clist);
+		AddBouquet(clist, true);
 	}
 	INFO("scan map size: %d -> %zd\n", old_size, scanmap.size());
 	return (old_size != scanmap.size());
@@ -145,7 +166,7 @@ bool CEpgScan::AddSelected()
 	for (unsigned j = 0; j < TVfavList->Bouquets.size(); ++j) {
 		if (TVfavList->Bouquets[j]->zapitBouquet && TVfavList->Bouquets[j]->zapitBouquet->bScanEpg) {
 			CChannelList * clist = TVfavList->Bouquets[j]->channelList;
-			AddBouquet(clist);
+			AddBouquet(clist, true);
 		}
 	}
 	for (unsigned j = 0; j < TVbouquetList->Bouquets.size(); ++j) {
@@ -180,7 +201,7 @@ void CEpgScan::AddTransponders()
 
 		if ((current_bnum != bnum) && bscan) {
 			current_bnum = bnum;
-			AddBouquet(bouquetList->Bouquets[current_bnum]->channelList);
+			AddBouquet(bouquetList->Bouquets[current_bnum]->channelList, mode == LIST_MODE_FAV);
 		} else {
 			AddSelected();
 		}
@@ -197,7 +218,7 @@ void CEpgScan::AddTransponders()
 			allfav_done = false;
 			scanmap.clear();
 			current_bnum = bouquetList->getActiveBouquetNumber();
-			AddBouquet(bouquetList->Bouquets[current_bnum]->channelList);
+			AddBouquet(bouquetList->Bouquets[current_bnum]->channelList, mode == LIST_MODE_FAV);
 			INFO("Added bouquet #%d, scan map size: %zd", current_bnum, scanmap.size());
 		}
 	} else if (g_settings.epg_scan == SCAN_FAV) {
@@ -286,6 +307,7 @@ int CEpgScan::handleMsg(const neutrino_msg_t msg, neutrino_msg_data_t data)
 		newchan = CServiceManager::getInstance()->FindChannel(chid);
 		if (newchan) {
 			scanned.insert(newchan->getTransponderId());
+			scan_time[newchan->getTransponderId()] = time_monotonic();
 			scanmap.erase(newchan->getTransponderId());
 		}
 		INFO("EIT read complete [" PRINTF_CHANNEL_ID_TYPE "], scan map size: %zd", chid, scanmap.size());
@@ -329,6 +351,10 @@ void CEpgScan::AddTimer()
 
 void CEpgScan::EnterStandby()
 {
+	if (scan_start && scanmap.empty()) {
+		INFO("full scan of %zd transponders done in %lld ms", scanned.size(), (long long)(time_monotonic_ms() - scan_start));
+		scan_start = 0;
+	}
 	AddTimer();
 	if (standby) {
 		CZapit::getInstance()->SetCurrentChannelID(live_channel_id);
@@ -386,20 +412,29 @@ void CEpgScan::Next()
 #endif
 	}
 _repeat:
+	transponder_id_t best_tp = 0;
 	for (eit_scanmap_iterator_t it = scanmap.begin(); it != scanmap.end(); /* ++it*/) {
 		CZapitChannel * newchan = CServiceManager::getInstance()->FindChannel(it->second);
 		if (newchan == NULL) {
 			scanmap.erase(it++);
 			continue;
 		}
+		if (next_chid && !IsBetter(it->first, best_tp)) {
+			++it;
+			continue;
+		}
 		if (CFEManager::getInstance()->canTune(newchan)) {
-			INFO("try to tune [%s]", newchan->getName().c_str());
 			next_chid = newchan->getChannelID();
-			break;
+			best_tp = it->first;
 		} else
 			INFO("skip [%s], cannot tune", newchan->getName().c_str());
 		++it;
 	}
+	if (next_chid) {
+		INFO("try to tune [%s]", CServiceManager::getInstance()->GetServiceName(next_chid).c_str());
+		if (!scan_start)
+			scan_start = time_monotonic_ms();
+	}
 	if (!next_chid && ((g_settings.epg_scan == SCAN_FAV) && AddFavorites()))
 		goto _repeat;
 	if (!next_chid && ((g_settings.epg_scan == SCAN_SEL) && AddSelected()))
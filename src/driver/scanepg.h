@@ -25,6 +25,8 @@
 typedef std::map<transponder_id_t, t_channel_id> eit_scanmap_t;
 typedef std::pair<transponder_id_t, t_channel_id> eit_scanmap_pair_t;
 typedef eit_scanmap_t::iterator eit_scanmap_iterator_t;
+/* transponder -> monotonic time of last complete EIT read */
+typedef std::map<transponder_id_t, time_t> eit_scantime_t;
 
 class CEpgScan
 {
@@ -52,10 +54,14 @@ class CEpgScan
 		t_channel_id next_chid;
 		t_channel_id live_channel_id;
 		std::set<transponder_id_t> scanned;
+		std::set<transponder_id_t> fav_tps;
+		eit_scantime_t scan_time;
+		int64_t scan_start;
 		uint32_t rescan_timer;
 		bool scan_in_progress;
 
-		void AddBouquet(CChannelList * clist);
+		void AddBouquet(CChannelList * clist, bool fav = false);
+		bool IsBetter(transponder_id_t tp, transponder_id_t best);
 		bool AddFavorites();
 		bool AddSelected();
 		void AddTransponders();
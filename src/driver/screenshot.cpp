@@ -53,6 +53,10 @@ extern "C" {
 #include <jpeglib.h>
 }
 
+#if defined(BOXMODEL_CST_HD2) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#endif
+
 extern cVideo *videoDecoder;
 
 /* constructor, defaults is empty fname and CScreenShot::FORMAT_JPG format */
@@ -69,8 +73,6 @@ CScreenShot::CScreenShot(const std::string &fname, screenshot_format_t fmt)
 	pixel_data = NULL;
 	fd = NULL;
 	extra_osd = false;
-	scs_thread = 0;
-	pthread_mutex_init(&thread_mutex, NULL);
 	pthread_mutex_init(&getData_mutex, NULL);
 #endif // SCREENSHOT_INTERNAL
 }
@@ -78,7 +80,6 @@ CScreenShot::CScreenShot(const std::string &fname, screenshot_format_t fmt)
 CScreenShot::~CScreenShot()
 {
 #if SCREENSHOT_INTERNAL
-	pthread_mutex_destroy(&thread_mutex);
 	pthread_mutex_destroy(&getData_mutex);
 #endif // SCREENSHOT_INTERNAL
 //	printf("[CScreenShot::%s:%d] thread: %p\n", __func__, __LINE__, this);
@@ -137,35 +138,52 @@ bool CScreenShot::StartSync()
 
 #ifdef BOXMODEL_CST_HD2
 
+/* blend one OSD pixel over one video pixel, red/blue and green in parallel */
+static inline fb_pixel_t blendPixel(fb_pixel_t osd, fb_pixel_t video)
+{
+	uint32_t a = osd >> 24;
+	uint32_t na = 256 - a;
+	uint32_t rb = (((osd & 0x00ff00ff) * a + (video & 0x00ff00ff) * na) >> 8) & 0x00ff00ff;
+	uint32_t g  = (((osd & 0x0000ff00) * a + (video & 0x0000ff00) * na) >> 8) & 0x0000ff00;
+	return (video & 0xff000000) | rb | g;
+}
+
 bool CScreenShot::mergeOsdScreen(uint32_t dx, uint32_t dy, fb_pixel_t* osdData)
 {
-	uint8_t* d = (uint8_t *)pixel_data;
-	fb_pixel_t* d2;
-
-	for (uint32_t count = 0; count < dy; count++ ) {
-		fb_pixel_t *pixpos = (fb_pixel_t*)&osdData[count*dx];
-		d2 = (fb_pixel_t*)d;
-		for (uint32_t count2 = 0; count2 < dx; count2++ ) {
-			//don't paint backgroundcolor (*pixpos = 0x00000000)
-			if (*pixpos) {
-				fb_pixel_t pix = *pixpos;
-				if ((pix & 0xff000000) == 0xff000000)
-					*d2 = (pix & 0x00ffffff);
-				else {
-					uint8_t *in = (uint8_t *)(pixpos);
-					uint8_t *out = (uint8_t *)d2;
-					int a = in[3];
-					*out = (*out + ((*in - *out) * a) / 256);
-					in++; out++;
-					*out = (*out + ((*in - *out) * a) / 256);
-					in++; out++;
-					*out = (*out + ((*in - *out) * a) / 256);
-				}
+	fb_pixel_t *d = (fb_pixel_t *)pixel_data;
+	fb_pixel_t *s = osdData;
+	fb_pixel_t *end = osdData + dx * dy;
+
+	while (s < end) {
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+		/* skip fully transparent runs four pixels at a time */
+		if (end - s >= 4) {
+			uint32x4_t v = vld1q_u32((const uint32_t *)s);
+			uint32x2_t o = vorr_u32(vget_low_u32(v), vget_high_u32(v));
+			if ((vget_lane_u32(o, 0) | vget_lane_u32(o, 1)) == 0) {
+				s += 4;
+				d += 4;
+				continue;
 			}
-			d2++;
-			pixpos++;
 		}
-		d += dx*sizeof(fb_pixel_t);
+#else
+		/* skip fully transparent runs two pixels at a time */
+		if (end - s >= 2 && (s[0] | s[1]) == 0) {
+			s += 2;
+			d += 2;
+			continue;
+		}
+#endif
+		fb_pixel_t pix = *s;
+		//don't paint backgroundcolor (pix = 0x00000000)
+		if (pix) {
+			if ((pix & 0xff000000) == 0xff000000)
+				*d = (pix & 0x00ffffff);
+			else
+				*d = blendPixel(pix, *d);
+		}
+		s++;
+		d++;
 	}
 	return true;
 }
@@ -246,65 +264,74 @@ bool CScreenShot::GetData()
 	return true;
 }
 
+pthread_t CScreenShot::worker_thread = 0;
+pthread_mutex_t CScreenShot::queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t CScreenShot::queue_cond = PTHREAD_COND_INITIALIZER;
+std::list<CScreenShot*> CScreenShot::queue;
+
+/* queue this screenshot for the worker thread, start worker if not running */
 bool CScreenShot::startThread()
 {
-	if (!scs_thread) {
-		void *ptr = static_cast<void*>(this);
-		int res = pthread_create(&scs_thread, NULL, initThread, ptr);
+	pthread_mutex_lock(&queue_mutex);
+	if (!worker_thread) {
+		int res = pthread_create(&worker_thread, NULL, workerThread, NULL);
 		if (res != 0) {
+			worker_thread = 0;
+			pthread_mutex_unlock(&queue_mutex);
 			printf("[CScreenShot::%s:%d] ERROR! pthread_create\n", __func__, __LINE__);
 			return false;
 		}
-		pthread_detach(scs_thread);
-		pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, 0);
-		pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, 0);
+		pthread_detach(worker_thread);
 	}
+	queue.push_back(this);
+	pthread_cond_signal(&queue_cond);
+	pthread_mutex_unlock(&queue_mutex);
 	return true;
 }
 
-void* CScreenShot::initThread(void *arg)
+/* worker thread: save queued screenshots one after another, delete them after saving */
+void* CScreenShot::workerThread(void *)
 {
-	CScreenShot *scs = static_cast<CScreenShot*>(arg);
-	pthread_cleanup_push(cleanupThread, scs);
-//	printf("[CScreenShot::%s:%d] thread: %p\n", __func__, __LINE__, scs);
-
-	scs->runThread();
-	pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, 0);
-	pthread_exit(0);
-
-	pthread_cleanup_pop(0);
+	set_threadname("n:screenshot");
+	pthread_mutex_lock(&queue_mutex);
+	while (true) {
+		while (queue.empty())
+			pthread_cond_wait(&queue_cond, &queue_mutex);
+		CScreenShot *scs = queue.front();
+		queue.pop_front();
+		pthread_mutex_unlock(&queue_mutex);
+
+		scs->runThread();
+		delete scs;
+
+		pthread_mutex_lock(&queue_mutex);
+	}
+	pthread_mutex_unlock(&queue_mutex);
 	return 0;
 }
 
-/* thread function to save data asynchroniosly. delete itself after saving */
 void CScreenShot::runThread()
 {
-	pthread_mutex_lock(&thread_mutex);
 	printf("[CScreenShot::%s:%d] save to %s format %d\n", __func__, __LINE__, filename.c_str(), format);
 
 	bool ret = SaveFile();
 
 	printf("[CScreenShot::%s:%d] %s finished: %d\n", __func__, __LINE__, filename.c_str(), ret);
-	pthread_mutex_unlock(&thread_mutex);
 }
 
-void CScreenShot::cleanupThread(void *arg)
-{
-	CScreenShot *scs = static_cast<CScreenShot*>(arg);
-//	printf("[CScreenShot::%s:%d] thread: %p\n", __func__, __LINE__, scs);
-	delete scs;
-}
-
-/* start ::run in new thread to save file in selected format */
+/* queue ::run in worker thread to save file in selected format */
 bool CScreenShot::Start()
 {
-	set_threadname("n:screenshot");
-	bool ret = false;
-	if (GetData())
-		ret = startThread();
-	else
+	if (!GetData()) {
 		delete this;
-	return ret;
+		return false;
+	}
+	if (!startThread()) {
+		cs_free_uncached((void *) pixel_data);
+		delete this;
+		return false;
+	}
+	return true;
 }
 
 /* save file in sync mode, return true if save ok, or false */
@@ -409,8 +436,6 @@ bool CScreenShot::SavePng()
 	return true;
 }
 
-#define SWAP(x,y)       { x ^= y; y ^= x; x ^= y; }
-
 /* from libjpg example.c */
 struct my_error_mgr {
 	struct jpeg_error_mgr pub;    /* "public" fields */
@@ -440,14 +465,18 @@ bool CScreenShot::SaveJpg()
 	if(!OpenFile())
 		return false;
 
-	for (int y = 0; y < yres; y++) {
-		int xres1 = y*xres*3;
-		int xres2 = xres1+2;
-		for (int x = 0; x < xres; x++) {
-			int x2 = x*3;
-			memmove(pixel_data + x2 + xres1, pixel_data + x*4 + y*xres*4, 3);
-			SWAP(pixel_data[x2 + xres1], pixel_data[x2 + xres2]);
-		}
+	/* BGRA -> RGB in place, destination never overtakes source */
+	unsigned char *src = pixel_data;
+	unsigned char *dst = pixel_data;
+	unsigned char *end = pixel_data + xres * yres * 4;
+	while (src < end) {
+		unsigned char b = src[0];
+		unsigned char g = src[1];
+		dst[0] = src[2];
+		dst[1] = g;
+		dst[2] = b;
+		src += 4;
+		dst += 3;
 	}
 
 	struct jpeg_compress_struct cinfo;
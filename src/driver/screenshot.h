@@ -32,6 +32,8 @@
 #endif
 
 #include <pthread.h>
+#include <string>
+#include <list>
 
 class CScreenShot
 {
@@ -55,10 +57,14 @@ class CScreenShot
 #if SCREENSHOT_INTERNAL
 		unsigned char * pixel_data;
 		FILE *fd;
-		pthread_t  scs_thread;
-		pthread_mutex_t thread_mutex;
 		pthread_mutex_t getData_mutex;
 
+		/* one worker thread saves all queued screenshots in order */
+		static pthread_t worker_thread;
+		static pthread_mutex_t queue_mutex;
+		static pthread_cond_t queue_cond;
+		static std::list<CScreenShot*> queue;
+
 		bool GetData();
 		bool OpenFile();
 		bool SaveFile();
@@ -68,9 +74,8 @@ class CScreenShot
 		bool SaveBmp();
 
 		bool startThread();
-		static void* initThread(void *arg);
+		static void* workerThread(void *arg);
 		void runThread();
-		static void cleanupThread(void *arg);
 
 #ifdef BOXMODEL_CST_HD2
 		bool mergeOsdScreen(uint32_t dx, uint32_t dy, fb_pixel_t* osdData);
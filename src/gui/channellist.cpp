@@ -149,6 +149,7 @@ CChannelList::CChannelList(const char * const pName, bool phistoryMode, bool _vl
 
 	paint_events_index = -2;
 	paint_events_deferred = false;
+	row_cache_used = 0;
 	CFrameBuffer::getInstance()->OnAfterSetPallette.connect(sigc::mem_fun(this, &CChannelList::ResetModules));
 	CNeutrinoApp::getInstance()->OnAfterSetupFonts.connect(sigc::mem_fun(this, &CChannelList::ResetModules));
 }
@@ -156,6 +157,7 @@ CChannelList::CChannelList(const char * const pName, bool phistoryMode, bool _vl
 CChannelList::~CChannelList()
 {
 	ResetModules();
+	clearRowCache();
 }
 
 void CChannelList::SetChannelList(ZapitChannelList* zlist)
@@ -1052,6 +1054,7 @@ void CChannelList::hide()
 	if(header)
 		header->kill();
 
+	clearRowCache();
 	frameBuffer->paintBackgroundBoxRel(x, y, full_width, height + OFFSET_INTER + info_height);
 
 	//remove details line
@@ -2050,6 +2053,23 @@ void CChannelList::paintItem(int pos, const bool firstpaint)
 	if (!is_available)
 		color = COL_MENUCONTENTINACTIVE_TEXT;
 
+	/* unchanged row already rendered at this position: blit it back */
+	t_channel_id row_chid = 0;
+	std::string row_key;
+	if (curr < (*chanlist).size())
+	{
+		row_chid = (*chanlist)[curr]->getChannelID();
+		row_key = getRowKey(pos, curr, i_selected, i_marked, is_available);
+		if (restoreRow(row_chid, ypos, row_key))
+		{
+			if (paintbuttons)
+				paintButtonBar(is_available);
+			if (!firstpaint && i_selected)
+				updateVfd();
+			return;
+		}
+	}
+
 	if (!firstpaint || i_selected || getKey(curr) == CNeutrinoApp::getInstance()->channelList->getActiveChannelNumber())
 		  frameBuffer->paintBoxRel(x,ypos, width - SCROLLBAR_WIDTH, fheight, bgcolor, i_radius);
 
@@ -2322,11 +2342,102 @@ void CChannelList::paintItem(int pos, const bool firstpaint)
 			// name
 			g_Font[SNeutrinoSettings::FONT_TYPE_CHANNELLIST]->RenderString(x + OFFSET_INNER_MID + numwidth + pb_offset + pb_width + chan_name_offset, ypos + fheight, chan_name_len, chan_name, color);
 		}
+		saveRow(row_chid, ypos, row_key);
+
 		if (!firstpaint && curr == selected)
 			updateVfd();
 	}
 }
 
+/* everything paintItem() puts into the row rectangle, in one string */
+std::string CChannelList::getRowKey(int pos, unsigned int curr, bool i_selected, bool i_marked, bool is_available)
+{
+	CZapitChannel* chan = (*chanlist)[curr];
+	CChannelEvent *p_event = (displayMode == DISPLAY_MODE_NOW) ? &chan->currentEvent : &chan->nextEvent;
+
+	int pb_state = 0;
+	if (!p_event->description.empty() && g_settings.theme.progressbar_design_channellist != CProgressBar::PB_OFF)
+	{
+		if (displayMode == DISPLAY_MODE_NOW)
+		{
+			/* progress in percent, finer steps are not visible in the bar */
+			time_t jetzt = time(NULL);
+			if (p_event->duration > 0 && jetzt > p_event->startTime)
+				pb_state = (int) ((jetzt - p_event->startTime) * 100 / p_event->duration);
+		}
+		else
+			pb_state = (int) p_event->startTime;
+	}
+
+	int rec_mode = CRecordManager::getInstance()->GetRecordMode(chan->getChannelID());
+	bool pip = false;
+#if ENABLE_PIP
+	pip = chan->getChannelID() == CZapit::getInstance()->GetPipChannelID();
+#endif
+	char flags[160];
+	snprintf(flags, sizeof(flags), "%d:%d:%d:%d:%u:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:",
+		pos, x, width, fheight, numwidth, displayMode,
+		i_selected, i_marked, is_available, rec_mode, pip,
+		edit_state, this->historyMode, (i_selected && move_state == beMoving),
+		chan->number, chan->bLocked, chan->scrambled, chan->isHD() ? 1 : chan->isUHD() ? 2 : 0,
+		pb_state);
+
+	char settings[64];
+	snprintf(settings, sizeof(settings), "%d:%d:%d:%d:%d:",
+		g_settings.channellist_show_numbers, g_settings.channellist_show_res_icon,
+		g_settings.channellist_epgtext_alignment, g_settings.theme.progressbar_design_channellist,
+		g_settings.theme.progressbar_gradient);
+
+	return std::string(flags) + settings + (chan->getUrl().empty() ? "0:" : "1:") + chan->getName() + "\n" + p_event->description;
+}
+
+bool CChannelList::restoreRow(t_channel_id chid, int ypos, const std::string &key)
+{
+	row_cache_map_t::iterator it = row_cache.find(chid);
+	if (it == row_cache.end() || it->second.key != key)
+		return false;
+
+	frameBuffer->RestoreScreen(x, ypos, width - SCROLLBAR_WIDTH, fheight, it->second.pixels);
+	it->second.used = ++row_cache_used;
+	return true;
+}
+
+void CChannelList::saveRow(t_channel_id chid, int ypos, const std::string &key)
+{
+	int dx = width - SCROLLBAR_WIDTH;
+	if (dx <= 0 || fheight <= 0)
+		return;
+
+	row_cache_map_t::iterator it = row_cache.find(chid);
+	if (it == row_cache.end())
+	{
+		/* two pages of rows are enough to page back and forth */
+		if (row_cache.size() >= (size_t) std::max(2 * (int) listmaxshow, 16))
+		{
+			row_cache_map_t::iterator oldest = row_cache.begin();
+			for (row_cache_map_t::iterator i = row_cache.begin(); i != row_cache.end(); ++i)
+				if (i->second.used < oldest->second.used)
+					oldest = i;
+			delete[] oldest->second.pixels;
+			row_cache.erase(oldest);
+		}
+		row_cache_t entry;
+		entry.pixels = new fb_pixel_t[dx * fheight];
+		it = row_cache.insert(std::make_pair(chid, entry)).first;
+	}
+
+	frameBuffer->SaveScreen(x, ypos, dx, fheight, it->second.pixels);
+	it->second.key = key;
+	it->second.used = ++row_cache_used;
+}
+
+void CChannelList::clearRowCache()
+{
+	for (row_cache_map_t::iterator it = row_cache.begin(); it != row_cache.end(); ++it)
+		delete[] it->second.pixels;
+	row_cache.clear();
+}
+
 
 void CChannelList::updateVfd()
 {
@@ -2443,6 +2554,7 @@ void CChannelList::ResetModules()
 		delete 	cc_minitv;
 		cc_minitv = NULL;
 	}
+	clearRowCache();
 }
 
 void CChannelList::paintBody()
@@ -45,6 +45,7 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <pthread.h>
 #include <semaphore.h>
 
@@ -153,6 +154,21 @@ private:
 
 	bool headerNew;
 
+	/* rendered rows, restored instead of repainted while the list is shown */
+	typedef struct
+	{
+		std::string key;
+		fb_pixel_t *pixels;
+		unsigned long used;
+	} row_cache_t;
+	typedef std::map<t_channel_id, row_cache_t> row_cache_map_t;
+	row_cache_map_t row_cache;
+	unsigned long row_cache_used;
+	std::string getRowKey(int pos, unsigned int curr, bool i_selected, bool i_marked, bool is_available);
+	bool restoreRow(t_channel_id chid, int ypos, const std::string &key);
+	void saveRow(t_channel_id chid, int ypos, const std::string &key);
+	void clearRowCache();
+
 	void paintDetails(int index);
 	void clearItem2DetailsLine ();
 	void paintItem2DetailsLine (int pos);
@@ -22,6 +22,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <map>
 
 #include <global.h>
 #include <system/debug.h>
@@ -604,6 +607,100 @@ static void set_lua_variables(lua_State *L)
 	}
 }
 
+/* compiled scripts, reused as long as the script file is unchanged */
+#define LUA_BYTECODE_CACHE_MAX (4 * 1024 * 1024)
+
+typedef struct lua_bytecode
+{
+	struct timespec mtime;
+	off_t size;
+	unsigned long used;
+	std::string code;
+} lua_bytecode_t;
+typedef std::map<std::string, lua_bytecode_t> lua_bytecode_map_t;
+
+static lua_bytecode_map_t lua_bytecode_cache;
+static size_t lua_bytecode_size = 0;
+static unsigned long lua_bytecode_used = 0;
+static pthread_mutex_t lua_bytecode_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int lua_bytecode_writer(lua_State *, const void *p, size_t sz, void *ud)
+{
+	((std::string *)ud)->append((const char *)p, sz);
+	return 0;
+}
+
+/* like luaL_loadfile, but take the compiled chunk from cache if the file is unchanged */
+static int LuaLoadFileCached(lua_State *L, const char *fileName)
+{
+	struct stat st;
+	if (stat(fileName, &st) != 0 || !S_ISREG(st.st_mode))
+		return luaL_loadfile(L, fileName);
+
+	std::string chunkname = std::string("@") + fileName;
+	pthread_mutex_lock(&lua_bytecode_mutex);
+	lua_bytecode_map_t::iterator it = lua_bytecode_cache.find(fileName);
+	if (it != lua_bytecode_cache.end())
+	{
+		/* nanoseconds, an edit within the same second must not be missed */
+		if (it->second.mtime.tv_sec == st.st_mtim.tv_sec &&
+		    it->second.mtime.tv_nsec == st.st_mtim.tv_nsec &&
+		    it->second.size == st.st_size)
+		{
+			it->second.used = ++lua_bytecode_used;
+			int status = luaL_loadbuffer(L, it->second.code.data(), it->second.code.size(), chunkname.c_str());
+			pthread_mutex_unlock(&lua_bytecode_mutex);
+			if (status == 0)
+				return 0;
+			lua_pop(L, 1);
+			return luaL_loadfile(L, fileName);
+		}
+		lua_bytecode_size -= it->second.code.size();
+		lua_bytecode_cache.erase(it);
+	}
+	pthread_mutex_unlock(&lua_bytecode_mutex);
+
+	int status = luaL_loadfile(L, fileName);
+	if (status)
+		return status;
+
+	lua_bytecode_t entry;
+	entry.mtime = st.st_mtim;
+	entry.size = st.st_size;
+#if LUA_VERSION_NUM >= 503
+	if (lua_dump(L, lua_bytecode_writer, &entry.code, 0) != 0)
+#else
+	if (lua_dump(L, lua_bytecode_writer, &entry.code) != 0)
+#endif
+		return 0;
+	if (entry.code.size() > LUA_BYTECODE_CACHE_MAX / 2)
+		return 0;
+
+	pthread_mutex_lock(&lua_bytecode_mutex);
+	/* another thread may have compiled the same script meanwhile */
+	it = lua_bytecode_cache.find(fileName);
+	if (it != lua_bytecode_cache.end())
+	{
+		lua_bytecode_size -= it->second.code.size();
+		lua_bytecode_cache.erase(it);
+	}
+	/* drop least recently used scripts until the new one fits */
+	while (!lua_bytecode_cache.empty() && lua_bytecode_size + entry.code.size() > LUA_BYTECODE_CACHE_MAX)
+	{
+		lua_bytecode_map_t::iterator lru = lua_bytecode_cache.begin();
+		for (it = lua_bytecode_cache.begin(); it != lua_bytecode_cache.end(); ++it)
+			if (it->second.used < lru->second.used)
+				lru = it;
+		lua_bytecode_size -= lru->second.code.size();
+		lua_bytecode_cache.erase(lru);
+	}
+	entry.used = ++lua_bytecode_used;
+	lua_bytecode_size += entry.code.size();
+	lua_bytecode_cache[fileName] = entry;
+	pthread_mutex_unlock(&lua_bytecode_mutex);
+	return 0;
+}
+
 const char CLuaInstance::className[] = LUA_CLASSNAME;
 
 CLuaInstance::CLuaInstance()
@@ -637,7 +734,7 @@ void CLuaInstance::runScript(const char *fileName, std::vector<std::string> *arg
 {
 	// luaL_dofile(lua, fileName);
 	/* run the script */
-	int status = luaL_loadfile(lua, fileName);
+	int status = LuaLoadFileCached(lua, fileName);
 	if (status)
 	{
 		bool isString = lua_isstring(lua, -1);
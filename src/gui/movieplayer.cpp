@@ -113,6 +113,8 @@ extern CVolume* g_volume;
 extern CTimeOSD *FileTimeOSD;
 
 #define TIMESHIFT_SECONDS 3
+#define TIMESHIFT_WAIT_MS 10000
+#define TIMESHIFT_POLL_MS 20
 #define ISO_MOUNT_POINT "/media/iso"
 #define MUTE true
 #define NO_MUTE false
@@ -2747,25 +2749,31 @@ bool CMoviePlayerGui::PlayFileStart(void)
 		CVFD::getInstance()->ShowIcon(FP_ICON_PLAY, true);
 		if (timeshift != TSHIFT_MODE_OFF) {
 			startposition = -1;
-			int i;
 			int towait = (timeshift == TSHIFT_MODE_ON) ? TIMESHIFT_SECONDS+1 : TIMESHIFT_SECONDS;
-			int cnt = 500;
+			int64_t maxwait = TIMESHIFT_WAIT_MS;
 			if (IS_WEBCHAN(movie_info.channelId)) {
 				videoDecoder->setBlank(false);
-				cnt = 200;
+				maxwait = TIMESHIFT_WAIT_MS * 2 / 5;
 				towait = 20;
+			} else if (timeshift == TSHIFT_MODE_ON && g_settings.timeshift_pause) {
+				/* new timeshift starts paused at position 0, first data is
+				 * enough. the rest is recorded while paused */
+				towait = 0;
 			}
-			for(i = 0; i < cnt; i++) {
+			int64_t wait_start = time_monotonic_ms();
+			while (true) {
 				playback->GetPosition(position, duration, isWebChannel);
 				startposition = (duration - position);
 
 				//printf("CMoviePlayerGui::PlayFile: waiting for data, position %d duration %d (%d), start %d\n", position, duration, towait, startposition);
 				if (startposition > towait*1000)
 					break;
+				if (time_monotonic_ms() - wait_start >= maxwait)
+					break;
 
-				usleep(20000);
+				usleep(TIMESHIFT_POLL_MS * 1000);
 			}
-			printf("CMoviePlayerGui::PlayFile: waiting for data: i=%d position %d duration %d (%d), start %d\n", i, position, duration, towait, startposition);
+			printf("CMoviePlayerGui::PlayFile: waiting for data: %lld ms position %d duration %d (%d), start %d\n", (long long)(time_monotonic_ms() - wait_start), position, duration, towait, startposition);
 			if (timeshift == TSHIFT_MODE_REWIND) {
 				startposition = duration;
 			} else {
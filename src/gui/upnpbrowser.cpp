@@ -53,12 +53,16 @@
 #include <gui/upnpbrowser.h>
 #include <system/settings.h>
 #include <system/helpers.h>
+#include <system/set_threadname.h>
 #include <zapit/zapit.h>
 #include <hardware/video.h>
 
 extern cVideo *videoDecoder;
 extern CPictureViewer *g_PicViewer;
 
+#define UPNP_PAGE_CACHE		64	/* pages kept per browser session */
+#define UPNP_PREFETCH_QUEUE	4
+
 const struct button_label RescanButton = {NEUTRINO_ICON_BUTTON_BLUE, LOCALE_UPNPBROWSER_RESCAN};
 const struct button_label BrowseButtons[] =
 {
@@ -71,7 +75,12 @@ const struct button_label BrowseButtons[] =
 
 CUpnpBrowserGui::CUpnpBrowserGui()
 {
-	m_socket = new CUPnPSocket();
+	m_discovery = new CUPnPDiscovery("urn:schemas-upnp-org:service:ContentDirectory:1");
+	m_devices_generation = 0;
+	m_pages_used = 0;
+	m_prefetch_running = false;
+	pthread_mutex_init(&m_pages_mutex, NULL);
+	pthread_cond_init(&m_pages_cond, NULL);
 	m_frameBuffer = CFrameBuffer::getInstance();
 	m_playing_entry_is_shown = false;
 
@@ -165,7 +174,10 @@ CUpnpBrowserGui::~CUpnpBrowserGui()
 	sigFonts.disconnect();
 	sigPall.disconnect();
 
-	delete m_socket;
+	stopPrefetch();
+	pthread_cond_destroy(&m_pages_cond);
+	pthread_mutex_destroy(&m_pages_mutex);
+	delete m_discovery;
 	if (dline)
 	{
 		delete dline; dline = NULL;
@@ -202,7 +214,9 @@ int CUpnpBrowserGui::exec(CMenuTarget *parent, const std::string & /*actionKey*/
 	m_selecteddevice = 0;
 	timeout = 0;
 
+	startPrefetch();
 	selectDevice();
+	stopPrefetch();
 
 	stopAudio();
 
@@ -262,20 +276,26 @@ bool CUpnpBrowserGui::discoverDevices()
 	if (!m_devices.empty())
 		return true;
 
-	CHintBox hintbox(LOCALE_MESSAGEBOX_INFO, g_Locale->getText(LOCALE_UPNPBROWSER_SCANNING));
-	hintbox.paint();
-
+	/* known servers show up at once, the search runs in the background */
 	try
 	{
-		m_devices = m_socket->Discover("urn:schemas-upnp-org:service:ContentDirectory:1");
+		m_devices_generation = m_discovery->GetGeneration();
+		m_devices = m_discovery->GetDevices();
+		if (m_devices.empty())
+		{
+			CHintBox hintbox(LOCALE_MESSAGEBOX_INFO, g_Locale->getText(LOCALE_UPNPBROWSER_SCANNING));
+			hintbox.paint();
+			m_discovery->WaitForDevices(UPNP_SEARCH_TIMEOUT);
+			m_devices_generation = m_discovery->GetGeneration();
+			m_devices = m_discovery->GetDevices();
+			hintbox.hide();
+		}
 	}
 	catch (std::runtime_error &error)
 	{
-		hintbox.hide();
 		DisplayErrorMessage(error.what());
 		return false;
 	}
-	hintbox.hide();
 	if (m_devices.empty())
 	{
 		DisplayInfoMessage(g_Locale->getText(LOCALE_UPNPBROWSER_NOSERVERS));
@@ -284,6 +304,29 @@ bool CUpnpBrowserGui::discoverDevices()
 	return true;
 }
 
+/* servers came or went while the list is shown, keep the selected one */
+void CUpnpBrowserGui::updateDevices()
+{
+	std::string udn;
+	if (m_selecteddevice < m_devices.size())
+		udn = m_devices[m_selecteddevice].udn;
+
+	/* an empty list shows the "no servers" state */
+	m_devices_generation = m_discovery->GetGeneration();
+	m_devices = m_discovery->GetDevices();
+
+	m_selecteddevice = 0;
+	for (unsigned int i = 0; i < m_devices.size(); i++)
+	{
+		if (m_devices[i].udn == udn)
+		{
+			m_selecteddevice = i;
+			break;
+		}
+	}
+	m_deviceliststart = (m_selecteddevice / m_listmaxshow) * m_listmaxshow;
+}
+
 bool CUpnpBrowserGui::getResults(std::string id, unsigned int start, unsigned int count, std::list<UPnPAttribute> &results)
 {
 	std::list<UPnPAttribute>attribs;
@@ -554,7 +597,11 @@ void CUpnpBrowserGui::selectDevice()
 
 		if (msg == CRCInput::RC_timeout)
 		{
-			// nothing
+			if (m_discovery->GetGeneration() != m_devices_generation)
+			{
+				updateDevices();
+				refresh = true;
+			}
 		}
 		else if (CNeutrinoApp::getInstance()->backKey(msg))
 		{
@@ -574,7 +621,7 @@ void CUpnpBrowserGui::selectDevice()
 			int new_selected = UpDownKey(m_devices, msg_repeatok, m_listmaxshow, m_selecteddevice);
 			updateDeviceSelection(new_selected);
 		}
-		else if (msg == CRCInput::RC_right || msg == CRCInput::RC_ok)
+		else if ((msg == CRCInput::RC_right || msg == CRCInput::RC_ok) && !m_devices.empty())
 		{
 			m_folderplay = false;
 			selectItem("0");
@@ -584,8 +631,11 @@ void CUpnpBrowserGui::selectDevice()
 		else if (msg == CRCInput::RC_blue)
 		{
 			m_devices.clear();
+			m_discovery->Flush();
 			if (!discoverDevices())
 				return;
+			m_selecteddevice = 0;
+			m_deviceliststart = 0;
 			refresh = true;
 		}
 		else if (msg == NeutrinoMessages::RECORD_START ||
@@ -707,21 +757,27 @@ void CUpnpBrowserGui::playnext(void)
 	m_frameBuffer->Clear();
 }
 
-bool CUpnpBrowserGui::getItems(std::string id, unsigned int index, std::vector<UPnPEntry> *&entries, unsigned int &total)
+/* Browse one page of count entries, throws on transport and SOAP errors.
+   Runs on the prefetch thread too, so it must not touch any GUI state. */
+bool CUpnpBrowserGui::browsePage(CUPnPDevice &device, std::string id, unsigned int start, unsigned int count, UPnPPage &page)
 {
 	bool tfound = false;
 	bool rfound = false;
 	bool nfound = false;
 	unsigned int returned = 0;
+	std::list<UPnPAttribute>attribs;
 	std::list<UPnPAttribute>results;
 	std::list<UPnPAttribute>::iterator i;
+	std::vector<UPnPEntry> *entries = NULL;
 
-	delete entries;
-	entries = NULL;
+	attribs.push_back(UPnPAttribute("ObjectID", id));
+	attribs.push_back(UPnPAttribute("BrowseFlag", "BrowseDirectChildren"));
+	attribs.push_back(UPnPAttribute("Filter", "*"));
+	attribs.push_back(UPnPAttribute("StartingIndex", to_string(start)));
+	attribs.push_back(UPnPAttribute("RequestedCount", to_string(count)));
+	attribs.push_back(UPnPAttribute("SortCriteria", ""));
 
-	printf("getItems: getResults: index %d count %d\n", index, m_listmaxshow);
-	if (!getResults(id, index, m_listmaxshow, results))
-		return false;
+	results = device.SendSOAP("urn:schemas-upnp-org:service:ContentDirectory:1", "Browse", attribs);
 
 	for (i = results.begin(); i != results.end(); ++i)
 	{
@@ -732,24 +788,202 @@ bool CUpnpBrowserGui::getItems(std::string id, unsigned int index, std::vector<U
 		}
 		else if (i->first == "TotalMatches")
 		{
-			total = atoi(i->second.c_str());
+			page.total = atoi(i->second.c_str());
 			tfound = true;
 		}
 		else if (i->first == "Result")
 		{
+			delete entries;
 			entries = decodeResult(i->second);
 			rfound = true;
 		}
 	}
 	if (!entries || !nfound || !tfound || !rfound || returned != entries->size() || returned == 0)
 	{
-		if (entries)
+		delete entries;
+		return false;
+	}
+	page.entries.swap(*entries);
+	delete entries;
+	return true;
+}
+
+/* the page size is part of the key, it changes with fonts and geometry */
+std::string CUpnpBrowserGui::pageKey(std::string id, unsigned int start, unsigned int count)
+{
+	return m_devices[m_selecteddevice].udn + "\n" + id + "\n" + to_string(start) + "\n" + to_string(count);
+}
+
+void CUpnpBrowserGui::storePage(std::string key, UPnPPage &page)
+{
+	pthread_mutex_lock(&m_pages_mutex);
+	if (m_pages.size() >= UPNP_PAGE_CACHE && m_pages.find(key) == m_pages.end())
+	{
+		std::map<std::string, UPnPPage>::iterator oldest = m_pages.begin();
+		for (std::map<std::string, UPnPPage>::iterator it = m_pages.begin(); it != m_pages.end(); ++it)
+			if (it->second.used < oldest->second.used)
+				oldest = it;
+		m_pages.erase(oldest);
+	}
+	page.used = ++m_pages_used;
+	m_pages[key] = page;
+	pthread_mutex_unlock(&m_pages_mutex);
+}
+
+void CUpnpBrowserGui::prefetchPage(std::string id, unsigned int start)
+{
+	std::string key = pageKey(id, start, m_listmaxshow);
+
+	pthread_mutex_lock(&m_pages_mutex);
+	if (m_prefetch_running && !m_pages.count(key) && !m_pages_loading.count(key))
+	{
+		std::list<UPnPPrefetch>::iterator it;
+		for (it = m_prefetch.begin(); it != m_prefetch.end(); ++it)
+			if (it->key == key)
+				break;
+		if (it == m_prefetch.end())
 		{
-			delete entries;
-			entries = NULL;
+			/* paging on quickly makes older requests pointless */
+			if (m_prefetch.size() >= UPNP_PREFETCH_QUEUE)
+				m_prefetch.pop_front();
+			UPnPPrefetch request = { m_devices[m_selecteddevice], id, start, m_listmaxshow, key };
+			m_prefetch.push_back(request);
+			pthread_cond_broadcast(&m_pages_cond);
 		}
-		return false;
 	}
+	pthread_mutex_unlock(&m_pages_mutex);
+}
+
+void CUpnpBrowserGui::startPrefetch()
+{
+	pthread_mutex_lock(&m_pages_mutex);
+	m_pages.clear();
+	pthread_mutex_unlock(&m_pages_mutex);
+
+	if (m_prefetch_running)
+		return;
+	m_prefetch_running = true;
+	if (pthread_create(&m_prefetch_thread, NULL, prefetchThread, this))
+	{
+		perror("CUpnpBrowserGui: prefetch thread");
+		m_prefetch_running = false;
+	}
+}
+
+void CUpnpBrowserGui::stopPrefetch()
+{
+	if (!m_prefetch_running)
+		return;
+	pthread_mutex_lock(&m_pages_mutex);
+	m_prefetch_running = false;
+	m_prefetch.clear();
+	pthread_cond_broadcast(&m_pages_cond);
+	pthread_mutex_unlock(&m_pages_mutex);
+	pthread_join(m_prefetch_thread, NULL);
+
+	pthread_mutex_lock(&m_pages_mutex);
+	m_pages.clear();
+	pthread_mutex_unlock(&m_pages_mutex);
+}
+
+void CUpnpBrowserGui::prefetch()
+{
+	pthread_mutex_lock(&m_pages_mutex);
+	while (m_prefetch_running)
+	{
+		if (m_prefetch.empty())
+		{
+			pthread_cond_wait(&m_pages_cond, &m_pages_mutex);
+			continue;
+		}
+		UPnPPrefetch request = m_prefetch.back();
+		m_prefetch.pop_back();
+		m_pages_loading.insert(request.key);
+		pthread_mutex_unlock(&m_pages_mutex);
+
+		UPnPPage page;
+		bool ok = false;
+		try
+		{
+			ok = browsePage(request.device, request.id, request.start, request.count, page);
+		}
+		catch (std::runtime_error &error)
+		{
+			printf("CUpnpBrowserGui::prefetch: %s\n", error.what());
+		}
+		if (ok)
+			storePage(request.key, page);
+
+		pthread_mutex_lock(&m_pages_mutex);
+		m_pages_loading.erase(request.key);
+		pthread_cond_broadcast(&m_pages_cond);
+	}
+	pthread_mutex_unlock(&m_pages_mutex);
+}
+
+void *CUpnpBrowserGui::prefetchThread(void *arg)
+{
+	set_threadname("upnp:prefetch");
+	static_cast<CUpnpBrowserGui *>(arg)->prefetch();
+	return NULL;
+}
+
+bool CUpnpBrowserGui::getItems(std::string id, unsigned int index, std::vector<UPnPEntry> *&entries, unsigned int &total)
+{
+	std::string key = pageKey(id, index, m_listmaxshow);
+	UPnPPage page;
+	bool found = false;
+
+	delete entries;
+	entries = NULL;
+
+	pthread_mutex_lock(&m_pages_mutex);
+	/* not started yet: fetched right here instead */
+	for (std::list<UPnPPrefetch>::iterator it = m_prefetch.begin(); it != m_prefetch.end(); ++it)
+	{
+		if (it->key == key)
+		{
+			m_prefetch.erase(it);
+			break;
+		}
+	}
+	/* on its way: wait for it rather than asking the server twice */
+	while (m_pages_loading.count(key))
+		pthread_cond_wait(&m_pages_cond, &m_pages_mutex);
+	std::map<std::string, UPnPPage>::iterator it = m_pages.find(key);
+	if (it != m_pages.end())
+	{
+		it->second.used = ++m_pages_used;
+		page = it->second;
+		found = true;
+	}
+	pthread_mutex_unlock(&m_pages_mutex);
+
+	if (!found)
+	{
+		printf("getItems: browse: index %d count %d\n", index, m_listmaxshow);
+		try
+		{
+			if (!browsePage(m_devices[m_selecteddevice], id, index, m_listmaxshow, page))
+				return false;
+		}
+		catch (std::runtime_error &error)
+		{
+			DisplayErrorMessage(error.what());
+			return false;
+		}
+		storePage(key, page);
+	}
+
+	total = page.total;
+	entries = new std::vector<UPnPEntry>;
+	entries->swap(page.entries);
+
+	/* the pages next to this one are the likely next requests */
+	if (index + m_listmaxshow < total)
+		prefetchPage(id, index + m_listmaxshow);
+	if (index >= m_listmaxshow)
+		prefetchPage(id, index - m_listmaxshow);
 	return true;
 }
 
@@ -1016,22 +1250,31 @@ bool CUpnpBrowserGui::selectItem(std::string id)
 
 void CUpnpBrowserGui::paintDeviceInfo()
 {
-	CVFD::getInstance()->showMenuText(0, m_devices[m_selecteddevice].friendlyname.c_str(), -1, true);
-
 	// Info
 	std::string tmp;
 
-	// first line
-	tmp = m_devices[m_selecteddevice].manufacturer + " " +
-		m_devices[m_selecteddevice].manufacturerurl + "\n";
+	if (m_selecteddevice >= m_devices.size())
+	{
+		// all servers are gone
+		tmp = g_Locale->getText(LOCALE_UPNPBROWSER_NOSERVERS);
+		CVFD::getInstance()->showMenuText(0, tmp.c_str(), -1, true);
+	}
+	else
+	{
+		CVFD::getInstance()->showMenuText(0, m_devices[m_selecteddevice].friendlyname.c_str(), -1, true);
 
-	// second line
-	tmp += m_devices[m_selecteddevice].modelname + " " +
-		m_devices[m_selecteddevice].modelnumber + " " +
-		m_devices[m_selecteddevice].modeldescription + "\n";
+		// first line
+		tmp = m_devices[m_selecteddevice].manufacturer + " " +
+			m_devices[m_selecteddevice].manufacturerurl + "\n";
 
-	// third line
-	tmp += m_devices[m_selecteddevice].modelurl;
+		// second line
+		tmp += m_devices[m_selecteddevice].modelname + " " +
+			m_devices[m_selecteddevice].modelnumber + " " +
+			m_devices[m_selecteddevice].modeldescription + "\n";
+
+		// third line
+		tmp += m_devices[m_selecteddevice].modelurl;
+	}
 
 	topbox.setDimensionsAll(m_x, m_y, m_width, m_topbox_height);
 	topbox.setCorner(RADIUS_LARGE);
@@ -32,6 +32,10 @@
 
 #include <string>
 #include <sstream>
+#include <map>
+#include <set>
+#include <list>
+#include <pthread.h>
 #include <upnpclient.h>
 
 struct UPnPResource
@@ -58,6 +62,23 @@ struct UPnPEntry
 	int		type;
 };
 
+/* one page of a container, as returned by Browse */
+struct UPnPPage
+{
+	std::vector<UPnPEntry> entries;
+	unsigned int	total;
+	unsigned long	used;
+};
+
+struct UPnPPrefetch
+{
+	CUPnPDevice	device;
+	std::string	id;
+	unsigned int	start;
+	unsigned int	count;
+	std::string	key;
+};
+
 class CFrameBuffer;
 class CUpnpBrowserGui : public CMenuTarget, public CListHelpers
 {
@@ -71,7 +92,19 @@ class CUpnpBrowserGui : public CMenuTarget, public CListHelpers
 		sigc::connection sigFonts;
 		sigc::connection sigPall;
 		UPnPEntry      m_playing_entry;
-		CUPnPSocket   *m_socket;
+		CUPnPDiscovery *m_discovery;
+		unsigned int   m_devices_generation;
+
+		/* browse result cache, filled on demand and by read-ahead of the
+		   neighbour pages; all of it under m_pages_mutex */
+		std::map<std::string, UPnPPage> m_pages;
+		unsigned long  m_pages_used;
+		std::set<std::string> m_pages_loading;
+		std::list<UPnPPrefetch> m_prefetch;
+		bool           m_prefetch_running;
+		pthread_t      m_prefetch_thread;
+		pthread_mutex_t m_pages_mutex;
+		pthread_cond_t m_pages_cond;
 		CFrameBuffer *m_frameBuffer;
 		int            m_LastMode;
 		int            m_width;
@@ -107,6 +140,7 @@ class CUpnpBrowserGui : public CMenuTarget, public CListHelpers
 		CComponentsPicture *image;
 
 		bool discoverDevices();
+		void updateDevices();
 		void splitProtocol(std::string &protocol, std::string &prot, std::string &network, std::string &mime, std::string &additional);
 		bool getResults(std::string id, unsigned int start, unsigned int count, std::list<UPnPAttribute> &results);
 		std::vector<UPnPEntry> *decodeResult(std::string);
@@ -118,6 +152,14 @@ class CUpnpBrowserGui : public CMenuTarget, public CListHelpers
 		void paintDeviceInfo();
 		void playnext();
 
+		bool browsePage(CUPnPDevice &device, std::string id, unsigned int start, unsigned int count, UPnPPage &page);
+		std::string pageKey(std::string id, unsigned int start, unsigned int count);
+		void storePage(std::string key, UPnPPage &page);
+		void prefetchPage(std::string id, unsigned int start);
+		void startPrefetch();
+		void stopPrefetch();
+		void prefetch();
+		static void *prefetchThread(void *arg);
 		bool getItems(std::string id, unsigned int index, std::vector<UPnPEntry> *&entries, unsigned int &total);
 		bool updateItemSelection(std::string id, std::vector<UPnPEntry> *&entries, int newpos, unsigned int &selected, unsigned int &liststart);
 		bool selectItem(std::string);
@@ -602,6 +602,9 @@ CMenuGlobal::CMenuGlobal()
 	//creates needed select values with default value NO_WIDGET_ID = -1
 	for (uint i=0; i<MN_WIDGET_ID_MAX; ++i)
 		v_selected.push_back(NO_WIDGET_ID);
+
+	font_generation = 0;
+	CNeutrinoApp::getInstance()->OnAfterSetupFonts.connect(sigc::mem_fun(this, &CMenuGlobal::fontsChanged));
 }
 
 CMenuGlobal::~CMenuGlobal()
@@ -618,6 +621,12 @@ CMenuGlobal* CMenuGlobal::getInstance()
 		m = new CMenuGlobal();
 	return m;
 }
+
+unsigned int CMenuGlobal::getLayoutGeneration()
+{
+	unsigned int gen = font_generation + g_Locale->getGeneration();
+	return gen ? gen : 1;
+}
 //****************************************************************************************
 
 CMenuWidget::CMenuWidget()
@@ -654,6 +663,7 @@ void CMenuWidget::Init(const std::string &NameString, const std::string &Icon, c
 	fade 		= true;
 	scrollbar_width	= 0;
 	savescreen	= false;
+	size_calculated	= false;
 	preselected 	= -1;
 	nextShortcut	= 1;
 	current_page	= 0;
@@ -883,6 +893,8 @@ int CMenuWidget::exec(CMenuTarget* parent, const std::string &)
 	if(savescreen) {
 		calcSize();
 		saveScreen();
+		/* nothing changes the layout until the paint() below */
+		size_calculated = true;
 	}
 
 	/* make sure we start with a selectable item... */
@@ -1443,7 +1455,9 @@ void CMenuWidget::paint()
 	if (CInfoClock::getInstance()->isRun())
 		CInfoClock::getInstance()->block();
 
-	calcSize();
+	if (!size_calculated)
+		calcSize();
+	size_calculated = false;
 
 	CVFD::getInstance()->setMode(CVFD::MODE_MENU_UTF8 /*, nameString.c_str()*/);
 
@@ -2130,6 +2144,8 @@ void CMenuOptionChooser::init(  const std::string &OptionName,
 	observ                  = Observ;
 	pulldown                = Pulldown;
 	optionsSort             = OptionsSort;
+	options_width           = 0;
+	options_width_generation = 0;
 
 	if (Options || OptionsExt)
 	{
@@ -2173,6 +2189,7 @@ void CMenuOptionChooser::setOptions(const struct keyval * const Options, const u
 		opt = Options[i];
 		options.push_back(opt);
 	}
+	options_width_generation = 0;
 	if (used && x != -1)
 		paint(false);
 }
@@ -2183,6 +2200,7 @@ void CMenuOptionChooser::setOptions(const struct keyval_ext * const Options, con
 	number_of_options = Number_Of_Options;
 	for (unsigned int i = 0; i < number_of_options; i++)
 		options.push_back(Options[i]);
+	options_width_generation = 0;
 	if (used && x != -1)
 		paint(false);
 }
@@ -2226,6 +2244,7 @@ int CMenuOptionChooser::exec(CMenuTarget*)
 			opt.valname = (*it)->valname.c_str();
 			options.push_back(opt);
 		}
+		options_width_generation = 0;
 	}
 
 	if((msg == CRCInput::RC_ok) && pulldown) {
@@ -2322,11 +2341,15 @@ int CMenuOptionChooser::paint( bool selected)
 	return y+height;
 }
 
-int CMenuOptionChooser::getWidth(void)
+/* widest option value; measured once per option set, font and locale,
+   calcSize() asks for it on every paint of the menu */
+int CMenuOptionChooser::getOptionsWidth()
 {
-	int tw = g_Font[SNeutrinoSettings::FONT_TYPE_MENU]->getRenderWidth(getName());
-	int width = tw;
+	unsigned int gen = CMenuGlobal::getInstance()->getLayoutGeneration();
+	if (options_width_generation == gen)
+		return options_width;
 
+	options_width = 0;
 	for(unsigned int count = 0; count < options.size(); count++) {
 		int ow = 0;
 		if (options[count].valname)
@@ -2334,9 +2357,17 @@ int CMenuOptionChooser::getWidth(void)
 		else
 			ow = g_Font[SNeutrinoSettings::FONT_TYPE_MENU]->getRenderWidth(g_Locale->getText(options[count].value));
 
-		if (tw + ow > width)
-			width = tw + ow;
+		if (ow > options_width)
+			options_width = ow;
 	}
+	options_width_generation = gen;
+	return options_width;
+}
+
+int CMenuOptionChooser::getWidth(void)
+{
+	int tw = g_Font[SNeutrinoSettings::FONT_TYPE_MENU]->getRenderWidth(getName());
+	int width = tw + getOptionsWidth();
 
 	width += OFFSET_INNER_MID; /* min 10 pixels between option name and value. enough? */
 	std::string desc_text = getDescription();
@@ -436,8 +436,11 @@ class CMenuOptionChooser : public CAbstractMenuOptionChooser
 		CChangeObserver *	observ;
 		bool			pulldown;
 		bool                    optionsSort;
+		int			options_width;
+		unsigned int		options_width_generation;
 
 		void clearChooserOptions();
+		int getOptionsWidth();
 		void init(      const std::string &OptionName,
 				const neutrino_locale_t Name,
 				int * const OptionValue,
@@ -532,8 +535,12 @@ class CMenuOptionStringChooser : public CMenuItem
 		void rememberLastItem(bool remember = true) {hold_last_item = remember;}
 };
 
-class CMenuGlobal
+class CMenuGlobal : public sigc::trackable
 {
+	private:
+		unsigned int font_generation;
+		void fontsChanged() { font_generation++; }
+
 	public:
 		std::vector<int> v_selected;
 		
@@ -541,6 +548,9 @@ class CMenuGlobal
 		~CMenuGlobal();
 		
 		static CMenuGlobal* getInstance();
+
+		/* changes whenever fonts or locale are reloaded, never 0 */
+		unsigned int getLayoutGeneration();
 };
 
 class CMenuWidget : public CMenuTarget, public CComponentsSignals
@@ -600,6 +610,7 @@ class CMenuWidget : public CMenuTarget, public CComponentsSignals
 		int			from_wizard;
 		bool			fade;
 		bool			washidden;
+		bool			size_calculated;
 		int			nextShortcut;
 
 		void Init(const std::string &NameString, const std::string & Icon, const int mwidth, const mn_widget_id_t &w_index);
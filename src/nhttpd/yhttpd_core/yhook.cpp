@@ -7,6 +7,7 @@
 #include <cstdio>
 #include <cstring>
 #include <strings.h>
+#include <unistd.h>
 
 // UTF8 convert
 #include <zapit/zapit.h>
@@ -33,10 +34,13 @@ CyhookHandler::CyhookHandler()
 	outType = plain;
 	nonPair = false;
 	LastModified=0;
+	SendFd = -1;
 }
 
 CyhookHandler::~CyhookHandler()
 {
+	if (SendFd >= 0)
+		close(SendFd);
 }
 
 //=============================================================================
@@ -202,8 +206,66 @@ void CyhookHandler::session_init(CStringList _ParamList, CStringList _UrlData,
 	httpStatus = HTTP_OK;
 	ContentLength = 0;
 	LastModified = (time_t) - 1;
+	ETag.clear();
+	ContentEncoding.clear();
 	keep_alive = _keep_alive;
 	HookVarList.clear();
+	if (SendFd >= 0)
+		close(SendFd);
+	SendFd = -1;
+}
+
+//-----------------------------------------------------------------------------
+// Send an already opened file. The fd stays valid even if the file is
+// unlinked before the response is written, e.g. by mod_cache eviction.
+//-----------------------------------------------------------------------------
+void CyhookHandler::SendFile(const std::string& url, int fd) {
+	if (SendFd >= 0)
+		close(SendFd);
+	SendFd = fd;
+	SendFile(url);
+}
+
+//-----------------------------------------------------------------------------
+// RFC 7232: check request validators against the item to send.
+// If-None-Match takes precedence over If-Modified-Since.
+//-----------------------------------------------------------------------------
+bool CyhookHandler::NotModified(time_t last_modified, const std::string& etag) {
+	std::string if_none_match = HeaderList["If-None-Match"];
+	if (!if_none_match.empty()) {
+		if (etag.empty())
+			return false;
+		if (if_none_match == "*")
+			return true;
+		// weak comparison (RFC 7232 2.3.2): opaque tags match, W/ is ignored
+		std::string tag = (etag.compare(0, 2, "W/") == 0) ? etag.substr(2) : etag;
+		std::string::size_type pos = 0;
+		while (pos < if_none_match.length()) {
+			std::string::size_type next = if_none_match.find(',', pos);
+			if (next == std::string::npos)
+				next = if_none_match.length();
+			std::string item = trim(if_none_match.substr(pos, next - pos));
+			if (item.compare(0, 2, "W/") == 0)
+				item.erase(0, 2);
+			if (item == tag)
+				return true;
+			pos = next + 1;
+		}
+		return false;
+	}
+
+	if (HeaderList["If-Modified-Since"].empty()) // Have If-Modified-Since Requested by Browser?
+		return false;
+	struct tm mod;
+	if (strptime(HeaderList["If-Modified-Since"].c_str(), RFC1123FMT, &mod) == NULL)
+		return false;
+	mod.tm_isdst = 0; // daylight saving flag!
+	time_t if_modified_since = mktime(&mod); // Date given
+
+	// normalize obj_last_modified to GMT
+	struct tm *tmp = gmtime(&last_modified);
+	time_t last_modified_gmt = mktime(tmp);
+	return if_modified_since >= last_modified_gmt;
 }
 
 //=============================================================================
@@ -237,16 +299,16 @@ void CyhookHandler::session_init(CStringList _ParamList, CStringList _UrlData,
 //
 //	response-header = Accept-Ranges          ; not implemented
 //			| Age                     ; not implemented
-//			| ETag                    ; not implemented
+//			| ETag                    ; implemented for static and cached files
 //			| Location                ; implemented (redirection / Object moved)
 //			| Proxy-Authenticate      ; not implemented
 //			| Retry-After             ; not implemented
 //			| Server                  ; implemented
-//			| Vary                    ; not implemented
+//			| Vary                    ; implemented for gzip variants
 //			| WWW-Authenticate        ; implemented (by mod_auth and SendHeader)
 //
 //	entity-header  = Allow                    ; not implemented
-//			| Content-Encoding         ; not implemented
+//			| Content-Encoding         ; implemented for gzip
 //			| Content-Language         ; not implemented
 //			| Content-Length           ; implemented
 //			| Content-Location         ; not implemented
@@ -315,8 +377,13 @@ std::string CyhookHandler::BuildHeader(bool cache) {
 #endif
 			result += "Connection: close\r\n";
 		// gzipped ?
-		if (UrlData["fileext"] == "gz")
+		if (!ContentEncoding.empty())
+			result += string_printf("Content-Encoding: %s\r\nVary: Accept-Encoding\r\n", ContentEncoding.c_str());
+		else if (UrlData["fileext"] == "gz")
 			result += "Content-Encoding: gzip\r\n";
+		// validator
+		if (!ETag.empty())
+			result += string_printf("ETag: %s\r\n", ETag.c_str());
 		// content-len, last-modified
 		if (httpStatus == HTTP_NOT_MODIFIED || httpStatus == HTTP_NOT_FOUND || httpStatus == HTTP_REQUEST_RANGE_NOT_SATISFIABLE)
 			result += "Content-Length: 0\r\n";
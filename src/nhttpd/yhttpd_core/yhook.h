@@ -136,7 +136,10 @@ public:
 	off_t		RangeStart;		// Start of range, used for sendfile only
 	off_t		RangeEnd;		// End of range, used for sendfile only
 	time_t 		LastModified;		// Last Modified Time of Item to send / -1 dynamic content
+	std::string	ETag;			// Entity Tag of Item to send / empty: none
+	std::string	ContentEncoding;	// Content-Encoding of Item to send / empty: identity
 	std::string	Sendfile;		// Path & Name (local os style) of file to send
+	int		SendFd;			// already opened file to send instead of NewURL / -1: none
 	bool		keep_alive;
 	bool		cached;			// cached by mod_cache
 	bool		nonPair;
@@ -196,8 +199,11 @@ public:
 	void SendError(std::string error = "");
 	void SendResult(std::string _content);
 	void SendFile(const std::string& url)		{NewURL = url; status = HANDLED_SENDFILE;}
+	void SendFile(const std::string& url, int fd);	// takes ownership of fd
+	int TakeSendFd()				{int fd = SendFd; SendFd = -1; return fd;}
 	void SendRedirect(const std::string& url)	{httpStatus=HTTP_MOVED_TEMPORARILY; NewURL = url; status = HANDLED_REDIRECTION;}
 	void SendRewrite(const std::string& url)	{NewURL = url; status = HANDLED_REWRITE;}
+	bool NotModified(time_t last_modified, const std::string& etag);
 
 	bool ParamList_exist(std::string keyword);
 
@@ -140,9 +140,17 @@ bool CWebserverResponse::SendResponse() {
 		//		if(Connection->HookHandler.UrlData["path"] == "/tmp/")//TODO: un-cachable dirs
 		//			cache = false;
 		Write(Connection->HookHandler.BuildHeader(cache));
-		if (Connection->Method != M_HEAD)
-			Sendfile(Connection->Request.UrlData["url"], Connection->HookHandler.RangeStart,
-				(Connection->HookHandler.RangeStart == 0 && Connection->HookHandler.RangeEnd == -1) ? -1 : Connection->HookHandler.RangeEnd - Connection->HookHandler.RangeStart + 1);
+		int filed = Connection->HookHandler.TakeSendFd();
+		if (Connection->Method != M_HEAD) {
+			off_t start = Connection->HookHandler.RangeStart;
+			off_t end = (start == 0 && Connection->HookHandler.RangeEnd == -1) ? -1 : Connection->HookHandler.RangeEnd - start + 1;
+			if (filed != -1)
+				Sendfile(filed, start, end);
+			else
+				Sendfile(Connection->Request.UrlData["url"], start, end);
+		}
+		if (filed != -1)
+			close(filed);
 		return true;
 	}
 	if (Connection->HookHandler.status == HANDLED_SENDFILE && Connection->HookHandler.httpStatus == HTTP_REQUEST_RANGE_NOT_SATISFIABLE) {
@@ -205,13 +213,25 @@ bool CWebserverResponse::Sendfile(std::string filename, off_t start, off_t end)
 	int filed = open(filename.c_str(), O_RDONLY);
 	if (filed != -1) //can access file?
 	{
-		if (!Connection->sock->SendFile(filed, start, end))
-			Connection->RequestCanceled = true;
+		Sendfile(filed, start, end);
 		close(filed);
 	}
 	return (filed != -1);
 }
 
+//-----------------------------------------------------------------------------
+// Send an opened file, filed is not closed
+//-----------------------------------------------------------------------------
+bool CWebserverResponse::Sendfile(int filed, off_t start, off_t end) {
+	if (Connection->RequestCanceled)
+		return false;
+	if (!Connection->sock->SendFile(filed, start, end)) {
+		Connection->RequestCanceled = true;
+		return false;
+	}
+	return true;
+}
+
 //-----------------------------------------------------------------------------
 // Send File: Determine MIME-Type fro File-Extention
 //-----------------------------------------------------------------------------
@@ -6,6 +6,7 @@
 // system
 #include <stdio.h>
 #include <pthread.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 // yhttpd
 #include <yconfig.h>
@@ -18,6 +19,9 @@
 //=============================================================================
 pthread_mutex_t CmodCache::mutex = PTHREAD_MUTEX_INITIALIZER;
 TCacheList CmodCache::CacheList;
+off_t CmodCache::cache_size = 0;
+unsigned long CmodCache::use_count = 0;
+unsigned int CmodCache::file_count = 0;
 
 //-----------------------------------------------------------------------------
 // HOOK: Response Prepare Handler
@@ -30,39 +34,39 @@ THandleStatus CmodCache::Hook_PrepareResponse(CyhookHandler *hh) {
 	log_level_printf(4, "mod_cache prepare hook start url:%s\n",
 			hh->UrlData["fullurl"].c_str());
 	std::string url = hh->UrlData["fullurl"];
-	if (CacheList.find(url) != CacheList.end()) // is in Cache. Rewrite URL or not modified
-	{
-		hh->cached = true;
 
-		pthread_mutex_lock(&mutex); // yeah, its mine
-
-		// Check if modified
-		time_t if_modified_since = (time_t) - 1;
-		if (!hh->HeaderList["If-Modified-Since"].empty()) // Have If-Modified-Since Requested by Browser?
-		{
-			struct tm mod;
-			if (strptime(hh->HeaderList["If-Modified-Since"].c_str(),
-					RFC1123FMT, &mod) != NULL) {
-				mod.tm_isdst = 0; // daylight saving flag!
-				if_modified_since = mktime(&mod); // Date given
-			}
-		}
+	bool found = false;
+	bool not_modified = false;
+	int fd = -1;
+	TCache item;
+	pthread_mutex_lock(&mutex); // yeah, its mine
+	TCacheList::iterator it = CacheList.find(url);
+	if (it != CacheList.end()) {
+		it->second.last_used = ++use_count;
+		item = it->second;
+		not_modified = hh->NotModified(item.created, item.etag);
+		// open while locked, eviction may unlink the file right after
+		if (!not_modified)
+			fd = open(item.filename.c_str(), O_RDONLY);
+		found = (not_modified || fd != -1);
+	}
+	pthread_mutex_unlock(&mutex);
 
-		// normalize obj_last_modified to GMT
-		struct tm *tmp = gmtime(&(CacheList[url].created));
-		time_t obj_last_modified_gmt = mktime(tmp);
-		bool modified = (if_modified_since == (time_t) - 1)
-				|| (if_modified_since < obj_last_modified_gmt);
+	if (found) // is in Cache. Rewrite URL or not modified
+	{
+		hh->cached = true;
+		hh->ContentLength = item.size;
+		hh->LastModified = item.created;
+		hh->ETag = item.etag;
 
 		// Send file or not-modified header
-		if (modified) {
-			hh->SendFile(CacheList[url].filename);
-			hh->ResponseMimeType = CacheList[url].mime_type;
+		if (!not_modified) {
+			hh->SendFile(item.filename, fd);
+			hh->ResponseMimeType = item.mime_type;
 		} else
-			hh->SetHeader(HTTP_NOT_MODIFIED, CacheList[url].mime_type,
-					HANDLED_READY);
-		pthread_mutex_unlock(&mutex);
+			hh->SetHeader(HTTP_NOT_MODIFIED, item.mime_type, HANDLED_READY);
 	}
+
 	log_level_printf(4, "mod_cache hook prepare end status:%d\n",
 			(int) hh->status);
 
@@ -84,11 +88,21 @@ THandleStatus CmodCache::Hook_SendResponse(CyhookHandler *hh) {
 	{
 		AddToCache(hh, url, hh->yresult, hh->HookVarList["CacheMimeType"],
 				category); // create cache file and add to cache list
-		hh->cached = true;
-		hh->ContentLength = (hh->yresult).length();
-		hh->RangeEnd = (hh->yresult).length()-1;
-		hh->SendFile(CacheList[url].filename); // Send as file
-		hh->ResponseMimeType = CacheList[url].mime_type; // remember mime
+		pthread_mutex_lock(&mutex);
+		TCacheList::iterator it = CacheList.find(url);
+		int fd = -1;
+		if (it != CacheList.end())
+			fd = open(it->second.filename.c_str(), O_RDONLY); // before eviction can unlink it
+		if (fd != -1) {
+			hh->cached = true;
+			hh->ContentLength = (hh->yresult).length();
+			hh->RangeEnd = (hh->yresult).length()-1;
+			hh->LastModified = it->second.created;
+			hh->ETag = it->second.etag;
+			hh->SendFile(it->second.filename, fd); // Send as file
+			hh->ResponseMimeType = it->second.mime_type; // remember mime
+		}
+		pthread_mutex_unlock(&mutex);
 	} else if (hh->UrlData["path"] == "/y/") // /y/ commands
 	{
 		hh->status = HANDLED_READY;
@@ -112,6 +126,9 @@ THandleStatus CmodCache::Hook_ReadConfig(CConfigFile *Config,
 		CStringList &ConfigList) {
 	cache_directory = Config->getString("mod_cache.cache_directory", CACHE_DIR);
 	ConfigList["mod_cache.cache_directory"] = cache_directory;
+	std::string max_size = Config->getString("mod_cache.max_size", CACHE_MAX_SIZE);
+	ConfigList["mod_cache.max_size"] = max_size;
+	cache_max_size = atoll(max_size.c_str());
 	return HANDLED_CONTINUE;
 }
 
@@ -120,53 +137,89 @@ THandleStatus CmodCache::Hook_ReadConfig(CConfigFile *Config,
 //-------------------------------------------------------------------------
 void CmodCache::AddToCache(CyhookHandler *, std::string url,
 		std::string content, std::string mime_type, std::string category) {
+	off_t size = content.length();
+	if (cache_max_size > 0 && size > cache_max_size)
+		return; // would evict everything else
 	FILE *fd = NULL;
 	pthread_mutex_lock(&mutex);
-	std::string filename = cache_directory + "/" + itoa(CacheList.size()); // build cache filename
+	unsigned int file_no = file_count++;
+	std::string filename = cache_directory + "/" + itoa(file_no); // build cache filename
+	pthread_mutex_unlock(&mutex);
+
+	// write the file unlocked, it is not in the list yet
+	bool ok = false;
 	mkdir(cache_directory.c_str(), 0777); // Create Cache directory
 	if ((fd = fopen(filename.c_str(), "w")) != NULL) // open file
 	{
-		if (fwrite(content.c_str(), content.length(), 1, fd) == 1) // write cache file
-		{
-			CacheList[url].filename = filename; // add cache data item
-			CacheList[url].mime_type = mime_type;
-			CacheList[url].category = category;
-			CacheList[url].created = time(NULL);
-//			std::string test = CacheList[url].filename;
-		}
+		ok = (size == 0 || fwrite(content.c_str(), size, 1, fd) == 1); // write cache file
 		fflush(fd); // flush and close file
 		fclose(fd);
 	}
+	if (!ok) {
+		remove(filename.c_str());
+		return;
+	}
+
+	pthread_mutex_lock(&mutex);
+	TCacheList::iterator it = CacheList.find(url);
+	if (it != CacheList.end())
+		RemoveItem(it); // replaced
+	EvictLRU(size);
+	TCache &item = CacheList[url]; // add cache data item
+	item.filename = filename;
+	item.mime_type = mime_type;
+	item.category = category;
+	item.created = time(NULL);
+	item.size = size;
+	item.last_used = ++use_count;
+	item.etag = string_printf("\"c%u-%lx\"", file_no, (unsigned long) item.created);
+	cache_size += size;
 	pthread_mutex_unlock(&mutex); // Free
 }
 //-------------------------------------------------------------------------
+// Remove item and its file, mutex must be held
+//-------------------------------------------------------------------------
+void CmodCache::RemoveItem(TCacheList::iterator it) {
+	remove(it->second.filename.c_str()); // delete file
+	cache_size -= it->second.size;
+	CacheList.erase(it); // remove from list
+}
+//-------------------------------------------------------------------------
+// Remove least recently used items until needed bytes fit, mutex must be held
+//-------------------------------------------------------------------------
+void CmodCache::EvictLRU(off_t needed) {
+	if (cache_max_size <= 0)
+		return;
+	while (!CacheList.empty() && cache_size + needed > cache_max_size) {
+		TCacheList::iterator lru = CacheList.begin();
+		for (TCacheList::iterator i = CacheList.begin(); i != CacheList.end(); ++i)
+			if (i->second.last_used < lru->second.last_used)
+				lru = i;
+		log_level_printf(4, "mod_cache evict url:%s\n", lru->first.c_str());
+		RemoveItem(lru);
+	}
+}
+//-------------------------------------------------------------------------
 // Delete URL from cachelist
 //-------------------------------------------------------------------------
 void CmodCache::RemoveURLFromCache(std::string url) {
 	pthread_mutex_lock(&mutex); // yeah, its mine
-	if (CacheList.find(url) != CacheList.end()) {
-		remove((CacheList[url].filename).c_str()); // delete file
-		CacheList.erase(url); // remove from list
-	}
+	TCacheList::iterator it = CacheList.find(url);
+	if (it != CacheList.end())
+		RemoveItem(it);
 	pthread_mutex_unlock(&mutex); // Free
 }
 //-------------------------------------------------------------------------
 //-------------------------------------------------------------------------
 void CmodCache::RemoveCategoryFromCache(std::string category) {
 	pthread_mutex_lock(&mutex);
-	bool restart = false;
-	do {
-		restart = false;
-		TCacheList::iterator i = CacheList.begin();
-		for (; i != CacheList.end(); ++i) {
-			TCache *item = &((*i).second);
-			if (item->category == category) {
-				CacheList.erase(((*i).first));
-				restart = true;
-				break;
-			}
-		}
-	} while (restart);
+	TCacheList::iterator i = CacheList.begin();
+	while (i != CacheList.end()) {
+		if (i->second.category == category)
+			RemoveItem(i++);
+		else
+			++i;
+	}
 	pthread_mutex_unlock(&mutex);
 }
 
@@ -175,7 +228,8 @@ void CmodCache::RemoveCategoryFromCache(std::string category) {
 //-------------------------------------------------------------------------
 void CmodCache::DeleteCache(void) {
 	pthread_mutex_lock(&mutex); // yeah, its mine
-	CacheList.clear(); // Clear entire list
+	while (!CacheList.empty())
+		RemoveItem(CacheList.begin());
 	pthread_mutex_unlock(&mutex); // Free
 }
 
@@ -193,6 +247,10 @@ void CmodCache::yshowCacheInfo(CyhookHandler *hh) {
 			(getHookVersion()).c_str());
 	yresult += string_printf("Cache Directory: %s<br/>\n",
 			cache_directory.c_str());
+	pthread_mutex_lock(&mutex);
+	yresult += string_printf("Cache Size.....: %lld of %lld bytes<br/>\n",
+			(long long) cache_size, (long long) cache_max_size);
+	pthread_mutex_unlock(&mutex);
 	yresult += string_printf("</code>\n<br/><b>CACHE</b><br/>\n");
 
 	// cache list
@@ -9,6 +9,7 @@
 // system
 #include <pthread.h>
 // c++
+#include <cstdlib>
 #include <string>
 // yhttpd
 #include <yconfig.h>
@@ -20,7 +21,10 @@ typedef struct {
 	std::string filename;
 	std::string mime_type;
 	std::string category;
+	std::string etag;
 	time_t created;
+	off_t size;
+	unsigned long last_used;	// LRU stamp, see CmodCache::use_count
 } TCache;
 
 typedef std::map<std::string, TCache> TCacheList;
@@ -29,13 +33,20 @@ typedef std::map<std::string, TCache> TCacheList;
 class CmodCache: public Cyhook {
 private:
 	static TCacheList 	CacheList;
+	static off_t		cache_size;	// sum of all cache file sizes
+	static unsigned long	use_count;	// LRU clock
+	static unsigned int	file_count;	// for unique cache filenames
 	std::string 		cache_directory;
+	off_t			cache_max_size;
+	static void			RemoveItem(TCacheList::iterator it);
+	void				EvictLRU(off_t needed);
 	void 				yshowCacheInfo(CyhookHandler *hh);
 	void 				yCacheClear(CyhookHandler *hh);
 public:
 	static 				pthread_mutex_t mutex;
 
 	CmodCache() {
+		cache_max_size = atoll(CACHE_MAX_SIZE);
 	}
 	;
 	~CmodCache(void) {
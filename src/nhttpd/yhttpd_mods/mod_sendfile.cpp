@@ -4,7 +4,8 @@
 //-----------------------------------------------------------------------------
 // Send a File (main) with given path and filename.
 // It procuced a Response-Header (SendHeader).
-// It supports Client caching mechanism "If-Modified-Since".
+// It supports Client caching mechanism "If-Modified-Since" and "If-None-Match".
+// Pre-compressed <file>.gz variants are sent to clients accepting gzip.
 //-----------------------------------------------------------------------------
 // RFC 2616 / 14.25 If-Modified-Since
 //
@@ -82,6 +83,21 @@ THandleStatus CmodSendfile::Hook_PrepareResponse(CyhookHandler *hh) {
 		// build filename
 		std::string fullfilename = GetFileName(hh, hh->UrlData["path"],
 				hh->UrlData["filename"]);
+		// only a gzipped file found for a plain url?
+		bool gz_url = (hh->UrlData["fileext"] == "gz");
+		if (!gz_url && fullfilename.length() > 3 && fullfilename.compare(fullfilename.length() - 3, 3, ".gz") == 0)
+			hh->ContentEncoding = "gzip";
+		// prefer a pre-compressed variant, if the client accepts it
+		else if (!gz_url && !fullfilename.empty() && hh->HeaderList["Accept-Encoding"].find("gzip") != std::string::npos
+				&& hh->HeaderList["Range"].empty()) {
+			struct stat st_plain, st_gz;
+			std::string gzfilename = fullfilename + ".gz";
+			if (stat(fullfilename.c_str(), &st_plain) == 0 && stat(gzfilename.c_str(), &st_gz) == 0
+					&& S_ISREG(st_gz.st_mode) && st_gz.st_mtime >= st_plain.st_mtime) {
+				fullfilename = gzfilename;
+				hh->ContentEncoding = "gzip";
+			}
+		}
 		int filed;
 		if ((filed = OpenFile(hh, fullfilename)) != -1) //can access file?
 		{
@@ -96,22 +112,12 @@ THandleStatus CmodSendfile::Hook_PrepareResponse(CyhookHandler *hh) {
 			}
 			close(filed);
 
-			// check If-Modified-Since
-			time_t if_modified_since = (time_t) - 1;
-			if (!hh->HeaderList["If-Modified-Since"].empty()) {
-				struct tm mod;
-				if (strptime(hh->HeaderList["If-Modified-Since"].c_str(),
-						RFC1123FMT, &mod) != NULL) {
-					mod.tm_isdst = 0; // daylight saving flag!
-					if_modified_since = mktime(&mod);
-				}
-			}
+			// weak validator: modify date in seconds and size don't promise identical bytes
+			hh->ETag = string_printf("W/\"%lx-%llx%s\"", (unsigned long) hh->LastModified,
+					(unsigned long long) hh->ContentLength, hh->ContentEncoding.empty() ? "" : "-gz");
 
-			// normalize obj_last_modified to GMT
-			struct tm *tmp = gmtime(&(hh->LastModified));
-			time_t LastModifiedGMT = mktime(tmp);
-			bool modified = (if_modified_since == (time_t) - 1)
-					|| (if_modified_since < LastModifiedGMT);
+			// check If-None-Match / If-Modified-Since
+			bool modified = !hh->NotModified(hh->LastModified, hh->ETag);
 
 			// Send normal or not-modified header
 			if (modified) {
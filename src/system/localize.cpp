@@ -46,6 +46,7 @@
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #define ISO_639_TAB DATADIR "/iso-codes/iso-639.tab"
@@ -94,6 +95,8 @@ CLocaleManager::CLocaleManager()
 	memcpy(localeData, locale_real_names, sizeof(locale_real_names));
 	memcpy(defaultData, locale_real_names, sizeof(locale_real_names));
 	defaultDataMem = localeDataMem = NULL;
+	generation = 0;
+	initKeyIndex();
 
 	loadLocale(DEFAULT_LOCALE, true);
 }
@@ -102,6 +105,7 @@ CLocaleManager::~CLocaleManager()
 {
 	delete[] localeData;
 	delete[] defaultData;
+	delete[] keyIndex;
 
 	if (localeDataMem)
 		::free(localeDataMem);
@@ -109,15 +113,58 @@ CLocaleManager::~CLocaleManager()
 		::free(defaultDataMem);
 }
 
+static unsigned int hashKey(const char *key)
+{
+	/* FNV-1a */
+	unsigned int h = 2166136261u;
+	while (*key)
+		h = (h ^ (unsigned char) *key++) * 16777619u;
+	return h;
+}
+
+void CLocaleManager::initKeyIndex()
+{
+	unsigned int count = sizeof(locale_real_names)/sizeof(const char *);
+	unsigned int size = 1;
+	while (size < 2 * count)
+		size <<= 1;
+
+	keyIndexMask = size - 1;
+	keyIndex = new unsigned short[size];
+	memset(keyIndex, 0, size * sizeof(unsigned short));
+
+	/* slot value 0 means empty, entry 0 is never looked up */
+	for (unsigned int i = 1; i < count; i++)
+	{
+		unsigned int h = hashKey(locale_real_names[i]) & keyIndexMask;
+		while (keyIndex[h])
+			h = (h + 1) & keyIndexMask;
+		keyIndex[h] = i;
+	}
+}
+
+unsigned int CLocaleManager::findKey(const char * const key) const
+{
+	unsigned int h = hashKey(key) & keyIndexMask;
+	while (keyIndex[h])
+	{
+		if (!strcmp(key, locale_real_names[keyIndex[h]]))
+			return keyIndex[h];
+		h = (h + 1) & keyIndexMask;
+	}
+	return 0;
+}
+
 const char * path[2] = { LOCALEDIR_VAR, LOCALEDIR };
 
 CLocaleManager::loadLocale_ret_t CLocaleManager::loadLocale(const char * const locale, bool asdefault)
 {
-	FILE * fd = NULL;
 	char ** loadData = asdefault ? defaultData : localeData;
 
 	char **mem = asdefault ? &defaultDataMem : &localeDataMem;
 
+	generation++;
+
 	if(!asdefault && !strcmp(locale, DEFAULT_LOCALE)) {
 		if (*mem) {
 			free(*mem);
@@ -127,26 +174,33 @@ CLocaleManager::loadLocale_ret_t CLocaleManager::loadLocale(const char * const l
 		return UNICODE_FONT;
 	}
 
-	struct stat st;
+	int fd = -1;
 	for (unsigned int i = 0; i < 2; i++)
 	{
 		std::string filename = path[i];
 		filename += "/";
 		filename += locale;
 		filename += ".locale";
-		::stat(filename.c_str(), &st);
 		
-		fd = fopen(filename.c_str(), "r");
-		if (fd)
+		fd = open(filename.c_str(), O_RDONLY);
+		if (fd > -1)
 			break;
 	}
 	
-	if (!fd)
+	if (fd < 0)
 	{		
 		perror("cannot read locale");
 		return NO_SUCH_LOCALE;
 	}
 
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size == 0)
+	{
+		perror("loadLocale");
+		close(fd);
+		return NO_SUCH_LOCALE;
+	}
+
 	if (*mem) {
 		free (*mem);
 		*mem = NULL;
@@ -154,75 +208,76 @@ CLocaleManager::loadLocale_ret_t CLocaleManager::loadLocale(const char * const l
 
 	memcpy(loadData, locale_real_names, sizeof(locale_real_names));
 
+	/* the whole file in one go, texts are unescaped in place: each one is
+	   written to memp, which never overtakes the line being parsed */
 	*mem = (char *) malloc(st.st_size);
 	if (!*mem)
 	{
 		perror("loadLocale");
+		close(fd);
 		return NO_SUCH_LOCALE;
 	}
-	char *memp = *mem;
+	ssize_t size = 0;
+	while (size < st.st_size)
+	{
+		ssize_t r = read(fd, *mem + size, st.st_size - size);
+		if (r <= 0)
+			break;
+		size += r;
+	}
+	close(fd);
 
-	char *buf=NULL;
-	size_t len = 0;
+	char *memp = *mem;
+	char *p = *mem;
+	char *end = *mem + size;
 
-	while(!feof(fd))
+	while (p < end)
 	{
-		if(getline(&buf, &len, fd)!=-1)
+		char *key = p;
+		char *val = NULL;
+		char *eol = p;
+		for (; eol < end && *eol != 10 && *eol != 13; eol++)
 		{
-			char * val    = NULL;
-			char * tmpptr = buf;
-
-			for(; (*tmpptr!=10) && (*tmpptr!=13);tmpptr++)
+			if ((*eol == ' ') && (val == NULL))
 			{
-				if ((*tmpptr == ' ') && (val == NULL))
-				{
-					*tmpptr  = 0;
-					val      = tmpptr + 1;
-				}
+				*eol = 0;
+				val  = eol + 1;
 			}
-			*tmpptr = 0;
+		}
+		/* next line, empty ones and the \r of \r\n included */
+		p = eol;
+		while (p < end && (*p == 10 || *p == 13))
+			p++;
 
-			if (val == NULL)
-				continue;
+		if (val == NULL)
+			continue;
 
-			std::string text = val;
+		unsigned int i = findKey(key);
+		if (i == 0)
+		{
+			printf("[%s.locale] superfluous entry: %s\n", locale, key);
+			continue;
+		}
+		if (loadData[i] != locale_real_names[i])
+		{
+			printf("[%s.locale] dup entry: %s\n", locale, locale_real_names[i]);
+			continue;
+		}
 
-			int pos;
-			do
-			{
-				pos = text.find("\\n");
-				if ( pos!=-1 )
-				{
-					text.replace(pos, 2, "\n", 1);
-				}
-			} while ( ( pos != -1 ) );
-
-			unsigned int i;
-			for(i = 1; i < sizeof(locale_real_names)/sizeof(const char *); i++)
+		loadData[i] = memp;
+		for (char *s = val; s < eol; s++)
+		{
+			if (*s == '\\' && s + 1 < eol && s[1] == 'n')
 			{
-//printf("[%s] [%s]\n", buf,locale_real_names[i]);
-				if(!strcmp(buf,locale_real_names[i]))
-				{
-					if(loadData[i] == locale_real_names[i])
-					{
-						loadData[i] = memp;
-						size_t l = text.length() + 1;
-						memcpy(memp, text.c_str(), l);
-						memp += l;
-					}
-					else
-						printf("[%s.locale] dup entry: %s\n", locale, locale_real_names[i]);
-					break;
-				}
+				*memp++ = '\n';
+				s++;
 			}
-//			printf("i=%d\n", i);
-			if(i == sizeof(locale_real_names)/sizeof(const char *))
-				printf("[%s.locale] superfluous entry: %s\n", locale, buf);
+			else
+				*memp++ = *s;
 		}
+		/* there is always a byte left for this, at least the key went away */
+		*memp++ = 0;
 	}
-	fclose(fd);
-	if(buf)
-		free(buf);
 	if(memp - *mem > 0){
 		char *_mem = (char *) realloc(*mem, memp - *mem);
 		if (_mem) {
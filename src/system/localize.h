@@ -54,6 +54,14 @@ class CLocaleManager
 
 		char * localeDataMem;
 		char * defaultDataMem;
+
+		unsigned int generation;
+
+		/* open addressed hash of locale_real_names, key -> index */
+		unsigned short * keyIndex;
+		unsigned int keyIndexMask;
+		void initKeyIndex();
+		unsigned int findKey(const char * const key) const;
 		
 	public:
 		enum loadLocale_ret_t
@@ -67,6 +75,8 @@ class CLocaleManager
 		~CLocaleManager();
 
 		loadLocale_ret_t loadLocale(const char * const locale, bool asdefault = false);
+		/* bumped on every loadLocale(), texts measured before are stale */
+		unsigned int getGeneration() const { return generation; }
 
 		const char * getText(const neutrino_locale_t keyName) const;
 		std::string getString(const neutrino_locale_t keyName) const;
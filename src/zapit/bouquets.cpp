@@ -35,6 +35,7 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <dirent.h>
 
 #include <fstream>
@@ -1037,6 +1038,9 @@ void CBouquetManager::loadWebchannels(int mode)
 	INFO("[webchannels] reload start reason=%s mode=%s sources=%d", webchannels_active_reason.c_str(), tag, (int)webchannels_sources.size());
 
 	std::set<std::string> loaded_sources;
+	webbouquet_map_t webbouquets;
+	channel48_map_t channels48;
+	channelname_index_t channelnames;
 	for (std::list<std::string>::iterator it = webchannels_sources.begin(); it != webchannels_sources.end(); ++it)
 	{
 		std::string filename = (*it);
@@ -1121,11 +1125,7 @@ void CBouquetManager::loadWebchannels(int mode)
 					const char *prov = xmlGetAttribute(l0, "name");
 					if (!prov)
 						prov = (mode == MODE_WEBTV) ? "WebTV" : "WebRadio";
-					pbouquet = addBouquetIfNotExist(prov);
-					if (mode == MODE_WEBTV)
-						pbouquet->bWebtv = true;
-					else
-						pbouquet->bWebradio = true;
+					pbouquet = addWebBouquet(prov, mode, webbouquets);
 
 					while ((xmlGetNextOccurence(l1, (mode == MODE_WEBTV) ? "webtv" : "webradio")))
 					{
@@ -1147,8 +1147,8 @@ void CBouquetManager::loadWebchannels(int mode)
 						{
 							if (strcmp(epgid, "auto") == 0 && title)
 							{
-								CZapitChannel * channel = CServiceManager::getInstance()->FindChannelByPattern(title);
-								if (channel && !IS_WEBCHAN(channel->getChannelID()))
+								CZapitChannel * channel = findChannelByName(title, channelnames);
+								if (channel)
 								{
 									epg_id = channel->getChannelID();
 									INFO("* auto epg_id found for %s: " PRINTF_CHANNEL_ID_TYPE, title, epg_id);
@@ -1162,11 +1162,7 @@ void CBouquetManager::loadWebchannels(int mode)
 						if (genre)
 						{
 							std::string bname = prov ? std::string(std::string(prov) + " ") + genre : genre;
-							gbouquet = addBouquetIfNotExist(bname);
-							if (mode == MODE_WEBTV)
-								gbouquet->bWebtv = true;
-							else
-								gbouquet->bWebradio = true;
+							gbouquet = addWebBouquet(bname, mode, webbouquets);
 						}
 						if (title && url)
 						{
@@ -1216,7 +1212,7 @@ void CBouquetManager::loadWebchannels(int mode)
 			else if (m3u)
 			{
 				std::ifstream infile;
-				char cLine[1024];
+				std::string strLine;
 				std::string epg_url = "";
 				std::string title = "";
 				std::string prefix = "";
@@ -1225,31 +1221,31 @@ void CBouquetManager::loadWebchannels(int mode)
 				std::string epgid = "";
 				std::string alogo = "";
 				std::string script = "";
+				m3u_attr_map_t attrs;
 				CZapitBouquet* pbouquet = NULL;
 
 				infile.open(tmp_name.c_str(), std::ifstream::in);
 
-				while (infile.good())
+				while (std::getline(infile, strLine))
 				{
-					infile.getline(cLine, sizeof(cLine));
 					// remove CR
-					if(cLine[strlen(cLine) - 1] == '\r')
-						cLine[strlen(cLine) - 1] = 0;
-					std::string strLine = cLine;
+					if (!strLine.empty() && strLine[strLine.size() - 1] == '\r')
+						strLine.resize(strLine.size() - 1);
 
 					if (strLine.empty())
 						continue;
 
 					if (strLine.find(M3U_START_MARKER) != std::string::npos)
 					{
-						epg_url = "";
-						epg_url = ReadMarkerValue(strLine, TVG_URL_MARKER);
+						attrs.clear();
+						ParseM3UAttributes(strLine, attrs);
+						epg_url = M3UAttribute(attrs, TVG_URL_MARKER);
 						if (epg_url.empty())
-							epg_url = ReadMarkerValue(strLine, X_TVG_URL_MARKER);
+							epg_url = M3UAttribute(attrs, X_TVG_URL_MARKER);
 						if (epg_url.empty())
-							epg_url = ReadMarkerValue(strLine, URL_TVG_MARKER);
+							epg_url = M3UAttribute(attrs, URL_TVG_MARKER);
 						if (epg_url.empty())
-							epg_url = ReadMarkerValue(strLine, X_URL_TVG_MARKER);
+							epg_url = M3UAttribute(attrs, X_URL_TVG_MARKER);
 						//printf("tvg-url: %s\n", epg_url.c_str());
 						if (!epg_url.empty())
 						{
@@ -1265,9 +1261,11 @@ void CBouquetManager::loadWebchannels(int mode)
 					}
 					if (strLine.find(M3U_INFO_MARKER) != std::string::npos)
 					{
-						int fPos = strLine.find_last_of('"') != std::string::npos ? strLine.find_last_of('"') : 0;
-						int iColon = (int)strLine.find_first_of(':');
-						int iComma = (int)strLine.find_first_of(',',fPos);
+						size_t fPos = strLine.find_last_of('"');
+						if (fPos == std::string::npos)
+							fPos = 0;
+						size_t iColon = strLine.find_first_of(':');
+						size_t iComma = strLine.find_first_of(',', fPos);
 						title = "";
 						prefix = "";
 						group = "";
@@ -1276,30 +1274,26 @@ void CBouquetManager::loadWebchannels(int mode)
 						alogo = "";
 						script = "";
 
-						if (iColon >= 0 && iComma >= 0 && iComma > iColon)
+						if (iColon != std::string::npos && iComma != std::string::npos && iComma > iColon)
 						{
-							iComma++;
-							iColon++;
-							title = strLine.substr(iComma);
-							std::string strInfoLine = strLine.substr(iColon, --iComma - iColon);
-							prefix = ReadMarkerValue(strInfoLine, GROUP_PREFIX_MARKER);
-							group = ReadMarkerValue(strInfoLine, GROUP_NAME_MARKER);
-							desc = ReadMarkerValue(strInfoLine, TVG_NAME_MARKER);
-							epgid = ReadMarkerValue(strInfoLine, TVG_ID_MARKER);
-							alogo = ReadMarkerValue(strInfoLine, TVG_LOGO_MARKER);
-							script = ReadMarkerValue(strInfoLine, TVG_SCRIPT_MARKER);
+							title = strLine.substr(iComma + 1);
+							strLine.resize(iComma);
+							attrs.clear();
+							ParseM3UAttributes(strLine, attrs);
+							prefix = M3UAttribute(attrs, GROUP_PREFIX_MARKER);
+							group = M3UAttribute(attrs, GROUP_NAME_MARKER);
+							desc = M3UAttribute(attrs, TVG_NAME_MARKER);
+							epgid = M3UAttribute(attrs, TVG_ID_MARKER);
+							alogo = M3UAttribute(attrs, TVG_LOGO_MARKER);
+							script = M3UAttribute(attrs, TVG_SCRIPT_MARKER);
 						}
 
-						pbouquet = addBouquetIfNotExist((mode == MODE_WEBTV) ? "WebTV" : "WebRadio");
-						if (mode == MODE_WEBTV)
-							pbouquet->bWebtv = true;
-						else
-							pbouquet->bWebradio = true;
-
+						pbouquet = addWebBouquet((mode == MODE_WEBTV) ? "WebTV" : "WebRadio", mode, webbouquets);
 					}
 					else if (strLine[0] != '#')
 					{
-						char *url = NULL;
+						const char *cLine = strLine.c_str();
+						const char *url = NULL;
 						if ((url = strstr(cLine, "http://")) || (url = strstr(cLine, "https://")) || (url = strstr(cLine, "rtmp://")) || (url = strstr(cLine, "rtsp://")) || (url = strstr(cLine, "rtp://")) || (url = strstr(cLine, "mmsh://")) )
 						{
 							if (url != NULL)
@@ -1320,11 +1314,7 @@ void CBouquetManager::loadWebchannels(int mode)
 										bname = group;
 									else
 										bname += " " + group;
-									gbouquet = addBouquetIfNotExist(bname);
-									if (mode == MODE_WEBTV)
-										gbouquet->bWebtv = true;
-									else
-										gbouquet->bWebradio = true;
+									gbouquet = addWebBouquet(bname, mode, webbouquets);
 								}
 
 								t_channel_id chid = create_channel_id64(0, 0, 0, 0, 0, url);
@@ -1412,9 +1402,20 @@ void CBouquetManager::loadWebchannels(int mode)
 							url = url2;
 							free(url2);
 							t_channel_id tmpchid = (((t_channel_id)i3) << 32) | (((t_channel_id)i4) << 16) | (t_channel_id)i2;
-							CZapitChannel * tmp_channel = CServiceManager::getInstance()->FindChannel48(tmpchid);
-							if (tmp_channel)
+							if (channels48.empty())
 							{
+								/* lowest full id of the non-web channels wins. unlike
+								   FindChannel48, web channels are left out: they are
+								   added during the reload and have no EPG to borrow */
+								tallchans *allchans = CServiceManager::getInstance()->GetAllChannels();
+								for (tallchans_iterator cit = allchans->begin(); cit != allchans->end(); ++cit)
+									if (!IS_WEBCHAN(cit->first))
+										channels48.insert(std::make_pair(cit->first & 0xFFFFFFFFFFFFULL, &cit->second));
+							}
+							channel48_map_t::iterator c48 = channels48.find(tmpchid & 0xFFFFFFFFFFFFULL);
+							if (c48 != channels48.end())
+							{
+								CZapitChannel * tmp_channel = c48->second;
 								epg_id = tmp_channel->getChannelID();
 								//printf("e2 chan: %s\n",tmp_channel->getName().c_str());
 							}
@@ -1427,22 +1428,14 @@ void CBouquetManager::loadWebchannels(int mode)
 
 							desc = "e2 stream";
 
-							pbouquet = addBouquetIfNotExist((mode == MODE_WEBTV) ? "WebTV" : "WebRadio");
-							if (mode == MODE_WEBTV)
-								pbouquet->bWebtv = true;
-							else
-								pbouquet->bWebradio = true;
+							pbouquet = addWebBouquet((mode == MODE_WEBTV) ? "WebTV" : "WebRadio", mode, webbouquets);
 
 							CZapitBouquet* gbouquet = pbouquet;
 							if (!group.empty())
 							{
 								std::string bname = (mode == MODE_WEBTV) ? "WebTV" : "WebRadio";
 								bname += ": " + group;
-								gbouquet = addBouquetIfNotExist(bname);
-								if (mode == MODE_WEBTV)
-									gbouquet->bWebtv = true;
-								else
-									gbouquet->bWebradio = true;
+								gbouquet = addWebBouquet(bname, mode, webbouquets);
 							}
 
 							if (!url.empty())
@@ -1513,35 +1506,82 @@ bool CBouquetManager::LogoStop()
 	return (OpenThreads::Thread::join() == 0);
 }
 
+/* parallel logo downloads */
+#define LOGO_WORKERS 4
+
+typedef std::map<std::string, std::vector<t_channel_id> > logo_url_map_t;
+
+struct logo_pool_t
+{
+	CBouquetManager *owner;
+	logo_url_map_t::iterator next;
+	logo_url_map_t::iterator end;
+	pthread_mutex_t mutex;
+};
+
+void* CBouquetManager::LogoWorker(void *arg)
+{
+	logo_pool_t *pool = (logo_pool_t *)arg;
+	set_threadname("zapit:logo");
+	while (pool->owner->logo_running)
+	{
+		pthread_mutex_lock(&pool->mutex);
+		if (pool->next == pool->end)
+		{
+			pthread_mutex_unlock(&pool->mutex);
+			break;
+		}
+		logo_url_map_t::iterator it = pool->next++;
+		pthread_mutex_unlock(&pool->mutex);
+
+		/* one download per url, channels with the same logo share the file */
+		std::string nlogo = downloadUrlToLogo(it->first, LOGODIR_TMP, it->second.front());
+		if (nlogo == it->first)
+			continue;
+
+		pthread_mutex_lock(&pool->mutex);
+		for (std::vector<t_channel_id>::iterator cit = it->second.begin(); pool->owner->logo_running && cit != it->second.end(); ++cit)
+		{
+			CZapitChannel *cc = CServiceManager::getInstance()->FindChannel(*cit);
+			if (cc)
+				cc->setAlternateLogo(nlogo);
+		}
+		pthread_mutex_unlock(&pool->mutex);
+	}
+	return NULL;
+}
+
 void CBouquetManager::run()
 {
 	set_threadname(__func__);
 	//printf(">>>>>> LogoThread [%s] started...\n",__func__);
-	CZapitChannel *cc = NULL;
-	std::string ologo;
-	std::string nlogo;
-	t_channel_id chid = 0;
-	std::list<t_channel_id>::iterator it = LogoList.begin();
-	while (logo_running && it != LogoList.end())
+	logo_url_map_t urls;
+	for (std::list<t_channel_id>::iterator it = LogoList.begin(); logo_running && it != LogoList.end(); ++it)
 	{
-		chid = (*it);
-		cc = CServiceManager::getInstance()->FindChannel(chid);
-		if (logo_running && cc)
-			ologo = cc->getAlternateLogo();
-		else
-			break;
-		cc = CServiceManager::getInstance()->FindChannel(chid);
-		if (logo_running && cc)
-			nlogo = downloadUrlToLogo(ologo, LOGODIR_TMP, chid);
-		else
-			break;
-		cc = CServiceManager::getInstance()->FindChannel(chid);
-		if (logo_running && cc)
-			cc->setAlternateLogo(nlogo);
-		else
+		CZapitChannel *cc = CServiceManager::getInstance()->FindChannel(*it);
+		if (cc && !cc->getAlternateLogo().empty())
+			urls[cc->getAlternateLogo()].push_back(*it);
+	}
+
+	logo_pool_t pool;
+	pool.owner = this;
+	pool.next = urls.begin();
+	pool.end = urls.end();
+	pthread_mutex_init(&pool.mutex, NULL);
+
+	pthread_t workers[LOGO_WORKERS];
+	int count = 0;
+	for (; count < LOGO_WORKERS && count < (int)urls.size(); count++)
+	{
+		if (pthread_create(&workers[count], NULL, LogoWorker, &pool))
 			break;
-		it++;
 	}
+	if (count == 0)
+		LogoWorker(&pool);
+	for (int i = 0; i < count; i++)
+		pthread_join(workers[i], NULL);
+	pthread_mutex_destroy(&pool.mutex);
+
 	LogoList.clear();
 	logo_running = false;
 	//printf(">>>>>>> LogoThread [%s] stopped...\n",__func__);
@@ -1775,6 +1815,88 @@ void CBouquetManager::dump_EPGMapping(std::string mapfile_out)
 	fclose(outfile);
 }
 
+/* collect all key="value" pairs of a m3u line in one pass, keys include the '=' */
+void CBouquetManager::ParseM3UAttributes(const std::string &line, m3u_attr_map_t &attrs)
+{
+	size_t pos = 0;
+	while ((pos = line.find("=\"", pos)) != std::string::npos)
+	{
+		size_t kstart = pos;
+		while (kstart > 0 && !isspace((unsigned char)line[kstart - 1]) && line[kstart - 1] != ':' && line[kstart - 1] != ',' && line[kstart - 1] != '"')
+			kstart--;
+		size_t vstart = pos + 2;
+		size_t vend = line.find('"', vstart);
+		if (vend == std::string::npos)
+			break;
+		if (kstart < pos)
+			attrs.insert(std::make_pair(line.substr(kstart, pos + 1 - kstart), line.substr(vstart, vend - vstart)));
+		pos = vend + 1;
+	}
+}
+
+std::string CBouquetManager::M3UAttribute(const m3u_attr_map_t &attrs, const char* strMarkerName)
+{
+	m3u_attr_map_t::const_iterator it = attrs.find(strMarkerName);
+	if (it != attrs.end())
+		return it->second;
+	return std::string("");
+}
+
+/* addBouquetIfNotExist for web channels, cache avoids scanning all bouquets for every entry */
+CZapitBouquet* CBouquetManager::addWebBouquet(const std::string &name, int mode, webbouquet_map_t &cache)
+{
+	CZapitBouquet* bouquet;
+	webbouquet_map_t::iterator it = cache.find(name);
+	if (it != cache.end())
+		bouquet = it->second;
+	else
+	{
+		bouquet = addBouquetIfNotExist(name);
+		cache[name] = bouquet;
+	}
+	if (mode == MODE_WEBTV)
+		bouquet->bWebtv = true;
+	else
+		bouquet->bWebradio = true;
+	return bouquet;
+}
+
+static std::string channelname_key(const std::string &name)
+{
+	std::string key(name);
+	for (std::string::iterator it = key.begin(); it != key.end(); ++it)
+		*it = tolower((unsigned char) *it);
+	return key;
+}
+
+static bool channelname_less(const std::pair<std::string, CZapitChannel *> &a, const std::pair<std::string, CZapitChannel *> &b)
+{
+	return a.first < b.first;
+}
+
+/* FindChannelByPattern for the non-web channels: the lowest id whose name
+   starts with pattern, ignoring case. index is built on first use and kept
+   for one reload, a binary search replaces the scan over all channels */
+CZapitChannel* CBouquetManager::findChannelByName(const std::string &pattern, channelname_index_t &index)
+{
+	if (index.empty())
+	{
+		tallchans *allchans = CServiceManager::getInstance()->GetAllChannels();
+		for (tallchans_iterator it = allchans->begin(); it != allchans->end(); ++it)
+			if (!IS_WEBCHAN(it->first))
+				index.push_back(std::make_pair(channelname_key(it->second.getName()), &it->second));
+		std::sort(index.begin(), index.end(), channelname_less);
+	}
+
+	std::string key = channelname_key(pattern);
+	CZapitChannel *found = NULL;
+	channelname_index_t::iterator it = std::lower_bound(index.begin(), index.end(), std::make_pair(key, (CZapitChannel *) NULL), channelname_less);
+	for (; it != index.end() && it->first.compare(0, key.length(), key) == 0; ++it)
+		if (!found || it->second->getChannelID() < found->getChannelID())
+			found = it->second;
+	return found;
+}
+
 std::string CBouquetManager::ReadMarkerValue(std::string strLine, const char* strMarkerName)
 {
 	if (strLine.find(strMarkerName) != std::string::npos)
@@ -94,6 +94,10 @@ class CZapitBouquet
 };
 
 typedef std::vector<CZapitBouquet *> BouquetList;
+typedef std::map<std::string, CZapitBouquet *> webbouquet_map_t;
+typedef std::map<t_channel_id, CZapitChannel *> channel48_map_t;
+typedef std::vector<std::pair<std::string, CZapitChannel *> > channelname_index_t;
+typedef std::map<std::string, std::string> m3u_attr_map_t;
 
 class CBouquetManager : public OpenThreads::Thread
 {
@@ -116,8 +120,13 @@ class CBouquetManager : public OpenThreads::Thread
 		std::string reMapEpgXML(t_channel_id channelid);
 		void convert_E2_EPGMapping(std::string mapfile_in, std::string mapfile_out = "/tmp/epgmap.xml");
 		void dump_EPGMapping(std::string mapfile_out = "/tmp/epgmap.xml");
+		CZapitBouquet* addWebBouquet(const std::string &name, int mode, webbouquet_map_t &cache);
+		CZapitChannel* findChannelByName(const std::string &pattern, channelname_index_t &index);
+		static void ParseM3UAttributes(const std::string &line, m3u_attr_map_t &attrs);
+		static std::string M3UAttribute(const m3u_attr_map_t &attrs, const char* strMarkerName);
 		//logo downloads
 		void run();
+		static void* LogoWorker(void *arg);
 		bool LogoStart();
 		bool LogoStop();
 		bool logo_running;
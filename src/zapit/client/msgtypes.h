@@ -151,7 +151,8 @@ class CZapitMessages
 			CMD_GET_VIDEO_FORMAT	   = 113,
 			CMD_STOP_PIP			   = 114,
 			CMD_ZAPTO_EPG			   = 115,
-			CMD_LOCKRC				   = 116
+			CMD_LOCKRC				   = 116,
+			CMD_GET_ZAP_TIMES		   = 117
 		};
 
 	struct commandBoolean
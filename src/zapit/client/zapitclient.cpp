@@ -1313,6 +1313,14 @@ void CZapitClient::getVideoFormat(int *vf)
 	close_connection();
 }
 
+void CZapitClient::getZapTimes(responseZapTimes &times)
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex);
+	send(CZapitMessages::CMD_GET_ZAP_TIMES, 0, 0);
+	CBasicClient::receive_data((char* )&times, sizeof(times));
+	close_connection();
+}
+
 void CZapitClient::registerEvent(const unsigned int eventID, const unsigned int clientID, const char * const udsName)
 {
 	CEventServer::commandRegisterEvent msg;
@@ -246,6 +246,16 @@ class CZapitClient:public CBasicClient
 	typedef std::vector<responseGetSatelliteList> SatelliteList;
 
 
+	/* duration of the steps of the last live zap */
+	struct responseZapTimes
+	{
+		unsigned int tune_ms;
+		unsigned int pat_ms;	// 0 if the cached pmt pid was still valid
+		unsigned int pmt_ms;
+		unsigned int start_ms;	// from zap start until decoders started
+		bool fastzap;		// decoders started from cached pids
+	};
+
 	struct responseFESignal
 	{
 		unsigned int  sig;
@@ -520,6 +530,7 @@ class CZapitClient:public CBasicClient
 	void getMode43(int *m43);
 	void setMode43(int m43);
 	void getVideoFormat(int *vf);
+	void getZapTimes(responseZapTimes &times);
 
 	/****************************************/
 	/*					*/
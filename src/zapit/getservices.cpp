@@ -32,6 +32,8 @@
 #include <xmlinterface.h>
 #include <math.h>
 #include <sys/time.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <fstream>
 
@@ -47,6 +49,7 @@ CServiceManager::CServiceManager()
 	service_count = 0;
 	services_changed = false;
 	keep_numbers = false;
+	snapshot = NULL;
 }
 
 CServiceManager::~CServiceManager()
@@ -484,12 +487,7 @@ void CServiceManager::ParseTransponders(xmlNodePtr node, t_satellite_position sa
 			freq = (freq_id_t) (feparams.frequency/(1000*1000));
 
 		transponder_id_t tid = CREATE_TRANSPONDER_ID64(freq, satellitePosition,original_network_id,transport_stream_id);
-		transponder t(tid, feparams);
-
-		std::pair<std::map<transponder_id_t, transponder>::iterator,bool> ret;
-		ret = transponders.insert(transponder_pair_t(tid, t));
-		if (ret.second == false)
-			t.dump("[zapit] duplicate in all transponders:");
+		AddTransponder(tid, feparams);
 
 		/* read channels that belong to the current transponder */
 		ParseChannels(xmlChildrenNode(node), transport_stream_id, original_network_id, satellitePosition, freq, feparams.polarization, delsys);
@@ -497,10 +495,26 @@ void CServiceManager::ParseTransponders(xmlNodePtr node, t_satellite_position sa
 		/* hop to next transponder */
 		node = xmlNextNode(node);
 	}
+	SnapshotWrite('U', &satellitePosition, sizeof(satellitePosition));
 	UpdateSatTransponders(satellitePosition);
 	return;
 }
 
+void CServiceManager::AddTransponder(transponder_id_t tid, FrontendParameters &feparams)
+{
+	if (snapshot) {
+		SnapshotWrite('T', &tid, sizeof(tid));
+		SnapshotWrite(0, &feparams, sizeof(feparams));
+	}
+
+	transponder t(tid, feparams);
+
+	std::pair<std::map<transponder_id_t, transponder>::iterator,bool> ret;
+	ret = transponders.insert(transponder_pair_t(tid, t));
+	if (ret.second == false)
+		t.dump("[zapit] duplicate in all transponders:");
+}
+
 void CServiceManager::ParseChannels(xmlNodePtr node, const t_transport_stream_id transport_stream_id, const t_original_network_id original_network_id, t_satellite_position satellitePosition, freq_id_t freq, uint8_t polarization, delivery_system_t delsys)
 {
 	int dummy = 0;
@@ -510,6 +524,15 @@ void CServiceManager::ParseChannels(xmlNodePtr node, const t_transport_stream_id
 	if(sit != satellitePositions.end())
 		have_ptr = &sit->second.have_channels;
 
+	service_entry_t entry;
+	memset(&entry, 0, sizeof(entry));
+	entry.transport_stream_id = transport_stream_id;
+	entry.original_network_id = original_network_id;
+	entry.satellitePosition = satellitePosition;
+	entry.freq = freq;
+	entry.polarization = polarization;
+	entry.delsys = delsys;
+
 	while ((node = xmlGetNextOccurence(node, "S")) != NULL) {
 		*have_ptr = 1;
 		t_service_id service_id = xmlGetNumericAttribute(node, "i", 16);
@@ -517,89 +540,103 @@ void CServiceManager::ParseChannels(xmlNodePtr node, const t_transport_stream_id
 		const char *nptr = xmlGetAttribute(node, "n");
 		if(nptr)
 			name = nptr;
-		uint8_t service_type = xmlGetNumericAttribute(node, "t", 16);
-		uint16_t vpid = xmlGetNumericAttribute(node, "v", 16);
-		uint16_t apid = xmlGetNumericAttribute(node, "a", 16);
-		uint16_t pcrpid = xmlGetNumericAttribute(node, "p", 16);
-		uint16_t pmtpid = xmlGetNumericAttribute(node, "pmt", 16);
-		uint16_t txpid = xmlGetNumericAttribute(node, "tx", 16);
-		uint16_t vtype = xmlGetNumericAttribute(node, "vt", 16);
-		uint16_t scrambled = xmlGetNumericAttribute(node, "s", 16);
-		int number = xmlGetNumericAttribute(node, "num", 10);
-		int flags = xmlGetNumericAttribute(node, "f", 10);
+		entry.service_id = service_id;
+		entry.service_type = xmlGetNumericAttribute(node, "t", 16);
+		entry.vpid = xmlGetNumericAttribute(node, "v", 16);
+		entry.apid = xmlGetNumericAttribute(node, "a", 16);
+		entry.pcrpid = xmlGetNumericAttribute(node, "p", 16);
+		entry.pmtpid = xmlGetNumericAttribute(node, "pmt", 16);
+		entry.txpid = xmlGetNumericAttribute(node, "tx", 16);
+		entry.vtype = xmlGetNumericAttribute(node, "vt", 16);
+		entry.scrambled = xmlGetNumericAttribute(node, "s", 16);
+		entry.number = xmlGetNumericAttribute(node, "num", 10);
+		entry.flags = xmlGetNumericAttribute(node, "f", 10);
 		/* default if no flags present */
-		if (flags == 0)
-			flags = CZapitChannel::UPDATED;
+		if (entry.flags == 0)
+			entry.flags = CZapitChannel::UPDATED;
 
-		t_channel_id chid = CREATE_CHANNEL_ID64;
+		entry.chid = CREATE_CHANNEL_ID64;
 		const char *ptr = xmlGetAttribute(node, "action");
-		bool remove = ptr ? (!strcmp(ptr, "remove") || !strcmp(ptr, "replace")) : false;
-		bool add    = ptr ? (!strcmp(ptr, "add")    || !strcmp(ptr, "replace")) : true;
+		entry.remove = ptr ? (!strcmp(ptr, "remove") || !strcmp(ptr, "replace")) : false;
+		entry.add    = ptr ? (!strcmp(ptr, "add")    || !strcmp(ptr, "replace")) : true;
 
-		if (remove) {
-			int result = allchans.erase(chid);
-			printf("[getservices]: %s '%s' (sid=0x%x): %s", add ? "replacing" : "removing",
-					name.c_str(), service_id, result ? "succeded.\n" : "FAILED!\n");
+		AddService(entry, name);
+		node = xmlNextNode(node);
+	}
+	return;
+}
 
-			if(!result && remove && add)
-				add = false;//dont replace not existing channel
-		}
-		if(!add) {
-			node = xmlNextNode(node);
-			continue;
-		}
-		audio_map_set_t * pidmap = CZapit::getInstance()->GetSavedPids(chid);
-		if(pidmap)
-			apid = pidmap->apid;
+void CServiceManager::AddService(service_entry_t &entry, std::string &name)
+{
+	if (snapshot) {
+		SnapshotWrite('S', &entry, sizeof(entry), name.c_str());
+	}
 
-		CZapitChannel * channel = new CZapitChannel(name, chid, service_type,
-				satellitePosition, freq);
+	bool add = entry.add;
+	if (entry.remove) {
+		int result = allchans.erase(entry.chid);
+		printf("[getservices]: %s '%s' (sid=0x%x): %s", add ? "replacing" : "removing",
+				name.c_str(), entry.service_id, result ? "succeded.\n" : "FAILED!\n");
 
-		channel->delsys = delsys;
+		if(!result && add)
+			add = false;//dont replace not existing channel
+	}
+	if(!add)
+		return;
 
-		service_number_map_t * channel_numbers = (service_type == ST_DIGITAL_RADIO_SOUND_SERVICE) ? &radio_numbers : &tv_numbers;
+	t_channel_id chid = entry.chid;
+	uint16_t apid = entry.apid;
+	int number = entry.number;
 
-		if(!keep_numbers)
-			number = 0;
+	audio_map_set_t * pidmap = CZapit::getInstance()->GetSavedPids(chid);
+	if(pidmap)
+		apid = pidmap->apid;
 
-		if(number) {
-			have_numbers = true;
-			service_number_map_t::iterator it = channel_numbers->find(number);
-			if(it != channel_numbers->end()) {
-				printf("[zapit] duplicate channel number %d: %s id %" PRIx64 " freq %d\n", number,
-						name.c_str(), chid, freq);
-				number = 0;
-				dup_numbers = true; // force save after loading
-			} else
-				channel_numbers->insert(number);
-		}
+	CZapitChannel * channel = new CZapitChannel(name, chid, entry.service_type,
+			entry.satellitePosition, entry.freq);
 
-		bool ret = AddChannel(channel);
-		//printf("INS CHANNEL %s %x\n", name.c_str(), (int) &ret.first->second);
-		if(ret == false) {
-			printf("[zapit] duplicate channel %s id %" PRIx64 " freq %d (old %s at %d)\n",
-					name.c_str(), chid, freq, channel->getName().c_str(), channel->getFreqId());
-		} else {
-			service_count++;
-			channel->number = number;
-			channel->flags = flags;
-			channel->scrambled = scrambled;
-			channel->polarization = polarization;
-			if(pmtpid != 0 && (((channel->getServiceType() == ST_DIGITAL_RADIO_SOUND_SERVICE) && (apid > 0))
-						|| ( (channel->getServiceType() == ST_DIGITAL_TELEVISION_SERVICE)  && (vpid > 0) && (apid > 0))) ) {
-				DBG("[getserv] preset chan %s vpid %X sid %X tpid %X onid %X\n", name.c_str(), vpid, service_id, transport_stream_id, transport_stream_id);
-				channel->setVideoPid(vpid);
-				channel->setAudioPid(apid);
-				channel->setPcrPid(pcrpid);
-				channel->setPmtPid(pmtpid);
-				channel->setTeletextPid(txpid);
-				channel->setPidsFlag();
-				channel->type = vtype;
-			}
+	channel->delsys = entry.delsys;
+
+	service_number_map_t * channel_numbers = (entry.service_type == ST_DIGITAL_RADIO_SOUND_SERVICE) ? &radio_numbers : &tv_numbers;
+
+	if(!keep_numbers)
+		number = 0;
+
+	if(number) {
+		have_numbers = true;
+		service_number_map_t::iterator it = channel_numbers->find(number);
+		if(it != channel_numbers->end()) {
+			printf("[zapit] duplicate channel number %d: %s id %" PRIx64 " freq %d\n", number,
+					name.c_str(), chid, entry.freq);
+			number = 0;
+			dup_numbers = true; // force save after loading
+		} else
+			channel_numbers->insert(number);
+	}
+
+	bool ret = AddChannel(channel);
+	//printf("INS CHANNEL %s %x\n", name.c_str(), (int) &ret.first->second);
+	if(ret == false) {
+		printf("[zapit] duplicate channel %s id %" PRIx64 " freq %d (old %s at %d)\n",
+				name.c_str(), chid, entry.freq, channel->getName().c_str(), channel->getFreqId());
+	} else {
+		service_count++;
+		channel->number = number;
+		channel->flags = entry.flags;
+		channel->scrambled = entry.scrambled;
+		channel->polarization = entry.polarization;
+		if(entry.pmtpid != 0 && (((channel->getServiceType() == ST_DIGITAL_RADIO_SOUND_SERVICE) && (apid > 0))
+					|| ( (channel->getServiceType() == ST_DIGITAL_TELEVISION_SERVICE)  && (entry.vpid > 0) && (apid > 0))) ) {
+			DBG("[getserv] preset chan %s vpid %X sid %X tpid %X onid %X\n", name.c_str(), entry.vpid, entry.service_id, entry.transport_stream_id, entry.original_network_id);
+			channel->setVideoPid(entry.vpid);
+			channel->setAudioPid(apid);
+			channel->setPcrPid(entry.pcrpid);
+			channel->setPmtPid(entry.pmtpid);
+			channel->setTeletextPid(entry.txpid);
+			channel->setPidsFlag();
+			channel->type = entry.vtype;
 		}
-		node = xmlNextNode(node);
 	}
-	return;
 }
 
 void CServiceManager::FindTransponder(xmlNodePtr search)
@@ -902,6 +939,27 @@ bool CServiceManager::LoadScanXml(delivery_system_t delsys)
 	return false;
 }
 
+void CServiceManager::LoadScanXmls()
+{
+	fake_t_pos = 0xE11;
+	fake_c_pos = 0xF01;
+
+	if (CFEManager::getInstance()->haveSat()) {
+		INFO("Loading satellites...");
+		LoadScanXml(ALL_SAT);
+	}
+
+	if (CFEManager::getInstance()->haveCable()) {
+		INFO("Loading cables...");
+		LoadScanXml(ALL_CABLE);
+	}
+
+	if (CFEManager::getInstance()->haveTerr()) {
+		INFO("Loading terrestrial...");
+		LoadScanXml(ALL_TERR);
+	}
+}
+
 bool CServiceManager::LoadServices(bool only_current)
 {
 	if(CFEManager::getInstance()->getLiveFE() == NULL)
@@ -923,52 +981,41 @@ bool CServiceManager::LoadServices(bool only_current)
 	dup_numbers = false;
 
 	fake_tid = fake_nid = 0;
-	fake_t_pos = 0xE11;
-	fake_c_pos = 0xF01;
 
-	if (CFEManager::getInstance()->haveSat()) {
-		INFO("Loading satellites...");
-		LoadScanXml(ALL_SAT);
-	}
+	LoadScanXmls();
 
-	if (CFEManager::getInstance()->haveCable()) {
-		INFO("Loading cables...");
-		LoadScanXml(ALL_CABLE);
-	}
+	if (LoadSnapshot()) {
+		printf("[zapit] services loaded from " SERVICES_BIN "\n");
+	} else if ((parser = parseXmlFile(SERVICES_XML)) != NULL) {
+		services_bin_header_t header;
+		if (SnapshotStamp(header) && (snapshot = fopen(SERVICES_BIN ".tmp", "w")) != NULL)
+			fwrite(&header, sizeof(header), 1, snapshot);
 
-	if (CFEManager::getInstance()->haveTerr()) {
-		INFO("Loading terrestrial...");
-		LoadScanXml(ALL_TERR);
-	}
-
-	parser = parseXmlFile(SERVICES_XML);
-	if (parser != NULL) {
 		xmlNodePtr search = xmlDocGetRootElement(parser);
 		search = xmlChildrenNode(search);
 		while (search) {
 			const char * name = xmlGetAttribute(search, "name");
-			t_satellite_position position;
+			t_satellite_position position = 0;
 			std::string delivery_name = xmlGetName(search);
-			if (delivery_name == "sat") {
+			if (delivery_name == "sat")
 				position = xmlGetSignedNumericAttribute(search, "position", 10);
-				InitSatPosition(position, name, false, ALL_SAT);
-			} else if (delivery_name == "terrestrial") {
-				position = GetSatellitePosition(name);
-				if (!position)
-					position = fake_t_pos++;
-				InitSatPosition(position, name, false, ALL_TERR);
-			} else if (delivery_name == "cable") {
-				position = GetSatellitePosition(name);
-				if (!position)
-					position = fake_c_pos++;
-				InitSatPosition(position, name, false, ALL_CABLE);
-			} else {
-			}
+			InitServicesPosition(delivery_name, name, position);
 
 			search = xmlNextNode(search);
 		}
 		FindTransponder(xmlChildrenNode(xmlDocGetRootElement(parser)));
 		xmlFreeDoc(parser);
+
+		if (snapshot) {
+			SnapshotWrite('E', NULL, 0);
+			bool ok = !ferror(snapshot);
+			ok = (fclose(snapshot) == 0) && ok;
+			snapshot = NULL;
+			if (ok)
+				rename(SERVICES_BIN ".tmp", SERVICES_BIN);
+			else
+				unlink(SERVICES_BIN ".tmp");
+		}
 	}
 
 	LoadProviderMap();
@@ -1011,6 +1058,183 @@ do_current:
 	return true;
 }
 
+t_satellite_position CServiceManager::InitServicesPosition(std::string &delivery_name, const char * name, t_satellite_position position)
+{
+	if (snapshot) {
+		SnapshotWrite('P', &position, sizeof(position), delivery_name.c_str());
+		SnapshotWrite(0, NULL, 0, name ? name : "");
+	}
+
+	if (delivery_name == "sat") {
+		InitSatPosition(position, name, false, ALL_SAT);
+	} else if (delivery_name == "terrestrial") {
+		position = GetSatellitePosition(name);
+		if (!position)
+			position = fake_t_pos++;
+		InitSatPosition(position, name, false, ALL_TERR);
+	} else if (delivery_name == "cable") {
+		position = GetSatellitePosition(name);
+		if (!position)
+			position = fake_c_pos++;
+		InitSatPosition(position, name, false, ALL_CABLE);
+	}
+	return position;
+}
+
+/* record: type byte (0 continues the previous record), data, optional string */
+void CServiceManager::SnapshotWrite(char type, const void * data, size_t len, const char * str)
+{
+	if (!snapshot)
+		return;
+	if (type)
+		fputc(type, snapshot);
+	if (len)
+		fwrite(data, len, 1, snapshot);
+	if (str) {
+		uint16_t slen = strlen(str);
+		fwrite(&slen, sizeof(slen), 1, snapshot);
+		fwrite(str, slen, 1, snapshot);
+	}
+}
+
+bool CServiceManager::SnapshotSource(const char * file, services_bin_source_t &source)
+{
+	struct stat st;
+	if (stat(file, &st)) {
+		source.size = -1;
+		return true;
+	}
+
+	FILE * fp = fopen(file, "r");
+	if (!fp)
+		return false;
+	int ret = md5_stream(fp, source.md5);
+	fclose(fp);
+	if (ret)
+		return false;
+
+	source.mtime = st.st_mtime;
+	source.size = st.st_size;
+	return true;
+}
+
+bool CServiceManager::SnapshotStamp(services_bin_header_t &header)
+{
+	static const char * sources[SERVICES_BIN_SOURCES] = { SERVICES_XML, SATELLITES_XML, CABLES_XML, TERRESTRIAL_XML };
+
+	memset(&header, 0, sizeof(header));
+	for (int i = 0; i < SERVICES_BIN_SOURCES; i++)
+		if (!SnapshotSource(sources[i], header.source[i]))
+			return false;
+	if (header.source[0].size < 0)
+		return false;
+
+	/* positions of cables and terrestrial depend on the tuner types */
+	CFEManager * fem = CFEManager::getInstance();
+	if (fem->haveSat())
+		header.delsys |= SERVICES_BIN_SAT;
+	if (fem->haveCable())
+		header.delsys |= SERVICES_BIN_CABLE;
+	if (fem->haveTerr())
+		header.delsys |= SERVICES_BIN_TERR;
+
+	memcpy(header.magic, "NSVB", 4);
+	header.version = SERVICES_BIN_VERSION;
+	header.fe_size = sizeof(FrontendParameters);
+	header.entry_size = sizeof(service_entry_t);
+	return true;
+}
+
+bool CServiceManager::LoadSnapshot()
+{
+	services_bin_header_t stamp;
+	if (!SnapshotStamp(stamp))
+		return false;
+
+	int fd = open(SERVICES_BIN, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) || st.st_size < (off_t) sizeof(stamp)) {
+		close(fd);
+		return false;
+	}
+	/* whole file in one buffer, records are decoded in place */
+	size_t size = st.st_size;
+	unsigned char * buf = new unsigned char[size];
+	ssize_t done = read(fd, buf, size);
+	close(fd);
+	if (done != (ssize_t) size || memcmp(buf, &stamp, sizeof(stamp))) {
+		delete[] buf;
+		return false;
+	}
+
+	unsigned char * p = buf + sizeof(stamp);
+	unsigned char * end = buf + size;
+	bool ok = false;
+	std::string str, str2;
+
+#define SNAP_GET(ptr, len) \
+	if (p + (len) > end) break; memcpy(ptr, p, len); p += (len)
+#define SNAP_STR(s) { \
+	uint16_t slen; SNAP_GET(&slen, sizeof(slen)); \
+	if (p + slen > end) break; s.assign((char *) p, slen); p += slen; }
+
+	while (p < end) {
+		char type = *p++;
+		if (type == 'E') {
+			ok = true;
+			break;
+		} else if (type == 'P') {
+			t_satellite_position position;
+			SNAP_GET(&position, sizeof(position));
+			SNAP_STR(str);
+			SNAP_STR(str2);
+			InitServicesPosition(str, str2.c_str(), position);
+		} else if (type == 'T') {
+			transponder_id_t tid;
+			FrontendParameters feparams;
+			SNAP_GET(&tid, sizeof(tid));
+			SNAP_GET(&feparams, sizeof(feparams));
+			AddTransponder(tid, feparams);
+		} else if (type == 'S') {
+			service_entry_t entry;
+			SNAP_GET(&entry, sizeof(entry));
+			SNAP_STR(str);
+			sat_iterator_t sit = satellitePositions.find(entry.satellitePosition);
+			if (sit != satellitePositions.end())
+				sit->second.have_channels = 1;
+			AddService(entry, str);
+		} else if (type == 'U') {
+			t_satellite_position position;
+			SNAP_GET(&position, sizeof(position));
+			UpdateSatTransponders(position);
+		} else
+			break;
+	}
+#undef SNAP_GET
+#undef SNAP_STR
+	delete[] buf;
+
+	if (!ok) {
+		printf("[zapit] " SERVICES_BIN " corrupt, loading " SERVICES_XML "\n");
+		allchans.clear();
+		transponders.clear();
+		tv_numbers.clear();
+		radio_numbers.clear();
+		have_numbers = false;
+		dup_numbers = false;
+		service_count = 0;
+		/* the replay added positions and updated sat transponders,
+		   start the xml fallback from freshly loaded scan xmls */
+		satellitePositions.clear();
+		satelliteTransponders.clear();
+		LoadScanXmls();
+	}
+	return ok;
+}
+
 void CServiceManager::CopyFile(const char * from, const char * to)
 {
 	std::ifstream in(from, std::ios::in | std::ios::binary);
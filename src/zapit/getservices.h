@@ -59,6 +59,60 @@ typedef prov_replace_map_t::iterator prov_replace_map_iterator_t;
 
 typedef std::set<int> service_number_map_t;
 
+/* one <S> entry of services.xml, also the channel record of services.bin */
+typedef struct service_entry
+{
+	t_channel_id chid;
+	t_service_id service_id;
+	t_transport_stream_id transport_stream_id;
+	t_original_network_id original_network_id;
+	t_satellite_position satellitePosition;
+	freq_id_t freq;
+	delivery_system_t delsys;
+	uint8_t service_type;
+	uint8_t polarization;
+	uint16_t vpid;
+	uint16_t apid;
+	uint16_t pcrpid;
+	uint16_t pmtpid;
+	uint16_t txpid;
+	uint16_t vtype;
+	uint16_t scrambled;
+	int number;
+	int flags;
+	bool remove;
+	bool add;
+} service_entry_t;
+
+#define SERVICES_BIN_VERSION 2
+
+/* source file stamp, size -1 if the file is missing */
+typedef struct services_bin_source
+{
+	int64_t mtime;
+	int64_t size;
+	unsigned char md5[16];
+} services_bin_source_t;
+
+/* services.xml, satellites.xml, cables.xml, terrestrial.xml */
+#define SERVICES_BIN_SOURCES 4
+#define SERVICES_BIN_SAT	0x01
+#define SERVICES_BIN_CABLE	0x02
+#define SERVICES_BIN_TERR	0x04
+
+/* services.bin is only used if all sources and the tuner types still match
+ * this, the positions in it are derived from the scan xmls */
+typedef struct services_bin_header
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t fe_size;
+	uint32_t entry_size;
+	uint32_t delsys;
+	uint32_t reserved;
+	services_bin_source_t source[SERVICES_BIN_SOURCES];
+} services_bin_header_t;
+
 class CServiceManager
 {
 	private:
@@ -88,10 +142,21 @@ class CServiceManager
 		satellite_map_t satellitePositions;
 		sat_transponder_map_t satelliteTransponders;
 
+		/* services.bin being written while parsing services.xml */
+		FILE * snapshot;
+
 		bool ParseScanXml(delivery_system_t delsys);
 		void ParseTransponders(xmlNodePtr node, t_satellite_position satellitePosition, delivery_system_t delsys);
 		void ParseChannels(xmlNodePtr node, const t_transport_stream_id transport_stream_id, const t_original_network_id original_network_id, t_satellite_position satellitePosition, freq_id_t freq, uint8_t polarization, delivery_system_t delsys);
 		void FindTransponder(xmlNodePtr search);
+		t_satellite_position InitServicesPosition(std::string &delivery_name, const char * name, t_satellite_position position);
+		void AddTransponder(transponder_id_t tid, FrontendParameters &feparams);
+		void AddService(service_entry_t &entry, std::string &name);
+		void SnapshotWrite(char type, const void * data, size_t len, const char * str = NULL);
+		static bool SnapshotSource(const char * file, services_bin_source_t &source);
+		static bool SnapshotStamp(services_bin_header_t &header);
+		void LoadScanXmls();
+		bool LoadSnapshot();
 		void ParseSatTransponders(delivery_system_t delsys, xmlNodePtr search, t_satellite_position satellitePosition);
 
 		bool LoadScanXml(delivery_system_t delsys);
@@ -22,11 +22,13 @@
 
 #include "debug.h"
 #include "pat.h"
+#include "psicache.h"
 #include <hardware/dmx.h>
 
 CPat::CPat(int dnum)
 {
 	parsed = false;
+	version = -1;
 	dmxnum = dnum;
 }
 
@@ -39,6 +41,7 @@ void CPat::Reset()
 {
 	sidpmt.clear();
 	parsed = false;
+	version = -1;
 	ts_id  = 0;
 }
 
@@ -79,6 +82,7 @@ bool CPat::Parse()
 		}
 		/* set Transport_Stream_ID from pat */
 		ts_id = ((buffer[3] << 8) | buffer[4]);
+		version = (buffer[5] >> 1) & 0x1F;
 		/* loop over service id / program map table pid pairs */
 		for (i = 8; i < (((buffer[1] & 0x0F) << 8) | buffer[2]) + 3 - crc_len; i += 4) {
 			/* store program map table pid */
@@ -108,6 +112,16 @@ unsigned short CPat::GetPmtPid(t_service_id sid)
 
 bool CPat::Parse(CZapitChannel * const channel)
 {
+	transponder_id_t tp = channel->getTransponderId();
+	if (!parsed) {
+		CPsiCache * cache = CPsiCache::getInstance();
+		if (cache->GetPat(tp, sidpmt, ts_id))
+			parsed = true;
+		else if (Parse())
+			cache->PutPat(tp, sidpmt, ts_id, version);
+		else
+			cache->Abort(tp, PSI_CACHE_PAT);
+	}
 	unsigned short pid = GetPmtPid(channel->getServiceId());
 	if(pid > 0) {
 		channel->setPmtPid(pid);
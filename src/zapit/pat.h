@@ -38,6 +38,7 @@ class CPat
 		int dmxnum;
 		t_transport_stream_id ts_id;
 		bool parsed;
+		int version;
 		sidpmt_map_t sidpmt;
 
 	public:
@@ -0,0 +1,189 @@
+/*
+ * per-transponder PAT/PMT cache
+ *
+ * License: GPLv2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <string.h>
+#include <driver/abstime.h>
+#include "debug.h"
+#include "psicache.h"
+
+CPsiCache * CPsiCache::cache = NULL;
+
+CPsiCache::CPsiCache()
+{
+	pthread_mutex_init(&mutex, NULL);
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+CPsiCache::~CPsiCache()
+{
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&mutex);
+}
+
+CPsiCache * CPsiCache::getInstance()
+{
+	if (cache == NULL)
+		cache = new CPsiCache();
+	return cache;
+}
+
+/* called with mutex locked */
+bool CPsiCache::Get(psi_key_t &key, psi_entry_t &entry)
+{
+	struct timespec abs;
+	clock_gettime(CLOCK_MONOTONIC, &abs);
+	abs.tv_sec += PSI_CACHE_WAIT;
+
+	while (pending.find(key) != pending.end()) {
+		if (pthread_cond_timedwait(&cond, &mutex, &abs)) {
+			/* reader hangs, take over */
+			pending.erase(key);
+			break;
+		}
+	}
+
+	psi_cache_iterator_t it = tables.find(key);
+	if (it != tables.end()) {
+		if (time_monotonic() - it->second.time < PSI_CACHE_TIMEOUT) {
+			entry = it->second;
+			return true;
+		}
+		tables.erase(it);
+	}
+	pending.insert(key);
+	return false;
+}
+
+/* called with mutex locked */
+void CPsiCache::Put(psi_key_t &key, psi_entry_t &entry)
+{
+	entry.time = time_monotonic();
+	psi_cache_iterator_t it = tables.find(key);
+	if (it != tables.end() && it->second.version != entry.version) {
+		DBG("[psicache] tp %" PRIx64 " sid %x version %x -> %x\n", key.first, key.second, it->second.version, entry.version);
+		if (key.second == PSI_CACHE_PAT) {
+			/* new PAT, pmt pids may have moved */
+			psi_cache_iterator_t next;
+			for (psi_cache_iterator_t pit = tables.begin(); pit != tables.end(); pit = next) {
+				next = pit;
+				++next;
+				if (pit->first.first == key.first)
+					tables.erase(pit);
+			}
+		}
+	}
+	tables[key] = entry;
+	pending.erase(key);
+	pthread_cond_broadcast(&cond);
+}
+
+bool CPsiCache::GetPat(transponder_id_t tp, sidpmt_map_t &sidpmt, t_transport_stream_id &ts_id)
+{
+	psi_key_t key(tp, PSI_CACHE_PAT);
+	psi_entry_t entry;
+
+	pthread_mutex_lock(&mutex);
+	bool ret = Get(key, entry);
+	pthread_mutex_unlock(&mutex);
+	if (ret) {
+		sidpmt = entry.sidpmt;
+		ts_id = entry.ts_id;
+	}
+	return ret;
+}
+
+void CPsiCache::PutPat(transponder_id_t tp, sidpmt_map_t &sidpmt, t_transport_stream_id ts_id, int version)
+{
+	psi_key_t key(tp, PSI_CACHE_PAT);
+	psi_entry_t entry;
+	entry.version = version;
+	entry.pid = 0;
+	entry.ts_id = ts_id;
+	entry.sidpmt = sidpmt;
+
+	pthread_mutex_lock(&mutex);
+	Put(key, entry);
+	pthread_mutex_unlock(&mutex);
+}
+
+bool CPsiCache::GetPmt(transponder_id_t tp, unsigned short pid, unsigned short sid, unsigned char * buffer, int size)
+{
+	psi_key_t key(tp, sid);
+	psi_entry_t entry;
+
+	pthread_mutex_lock(&mutex);
+	bool ret = Get(key, entry);
+	pthread_mutex_unlock(&mutex);
+	if (ret) {
+		/* pmt pid changed without a new PAT seen, read again */
+		if (entry.pid != pid || (int) entry.section.size() > size) {
+			Invalidate(tp, sid);
+			return GetPmt(tp, pid, sid, buffer, size);
+		}
+		memcpy(buffer, &entry.section[0], entry.section.size());
+	}
+	return ret;
+}
+
+void CPsiCache::PutPmt(transponder_id_t tp, unsigned short pid, unsigned short sid, unsigned char * buffer)
+{
+	psi_key_t key(tp, sid);
+	psi_entry_t entry;
+	int len = (((buffer[1] & 0x0F) << 8) | buffer[2]) + 3;
+	entry.version = (buffer[5] >> 1) & 0x1F;
+	entry.pid = pid;
+	entry.ts_id = 0;
+	entry.section.assign(buffer, buffer + len);
+
+	pthread_mutex_lock(&mutex);
+	Put(key, entry);
+	pthread_mutex_unlock(&mutex);
+}
+
+/* read failed, wake up waiters so they can try themselves */
+void CPsiCache::Abort(transponder_id_t tp, int sid)
+{
+	psi_key_t key(tp, sid);
+
+	pthread_mutex_lock(&mutex);
+	pending.erase(key);
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&mutex);
+}
+
+void CPsiCache::Invalidate(transponder_id_t tp, int sid)
+{
+	psi_key_t key(tp, sid);
+
+	pthread_mutex_lock(&mutex);
+	tables.erase(key);
+	pthread_mutex_unlock(&mutex);
+}
+
+void CPsiCache::Clear()
+{
+	pthread_mutex_lock(&mutex);
+	tables.clear();
+	pthread_mutex_unlock(&mutex);
+}
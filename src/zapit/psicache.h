@@ -0,0 +1,83 @@
+/*
+ * per-transponder PAT/PMT cache
+ *
+ * License: GPLv2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef __zapit_psicache_h__
+#define __zapit_psicache_h__
+
+#include <pthread.h>
+#include <time.h>
+#include <map>
+#include <set>
+#include <vector>
+#include "types.h"
+#include "pat.h"
+
+/* seconds a table is used without being read again */
+#define PSI_CACHE_TIMEOUT	60
+/* max. seconds to wait for another reader of the same table */
+#define PSI_CACHE_WAIT		5
+
+/* key: transponder and service id, PSI_CACHE_PAT for the PAT */
+#define PSI_CACHE_PAT		-1
+typedef std::pair<transponder_id_t, int> psi_key_t;
+
+typedef struct psi_entry
+{
+	int version;
+	time_t time;
+	unsigned short pid;
+	t_transport_stream_id ts_id;
+	sidpmt_map_t sidpmt;
+	std::vector<unsigned char> section;
+} psi_entry_t;
+
+typedef std::map<psi_key_t, psi_entry_t> psi_cache_map_t;
+typedef psi_cache_map_t::iterator psi_cache_iterator_t;
+
+/* PAT and PMTs of all transponders recently used by live, record, pip and
+ * stream zaps. A get* call that misses marks the table as pending, the
+ * caller reads it and has to call put* (or abort on read error). Other
+ * callers asking for a pending table block until it arrived. */
+class CPsiCache
+{
+	private:
+		static CPsiCache * cache;
+		psi_cache_map_t tables;
+		std::set<psi_key_t> pending;
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
+
+		CPsiCache();
+		bool Get(psi_key_t &key, psi_entry_t &entry);
+		void Put(psi_key_t &key, psi_entry_t &entry);
+	public:
+		~CPsiCache();
+		static CPsiCache * getInstance();
+
+		bool GetPat(transponder_id_t tp, sidpmt_map_t &sidpmt, t_transport_stream_id &ts_id);
+		void PutPat(transponder_id_t tp, sidpmt_map_t &sidpmt, t_transport_stream_id ts_id, int version);
+		bool GetPmt(transponder_id_t tp, unsigned short pid, unsigned short sid, unsigned char * buffer, int size);
+		void PutPmt(transponder_id_t tp, unsigned short pid, unsigned short sid, unsigned char * buffer);
+		void Abort(transponder_id_t tp, int sid);
+		void Invalidate(transponder_id_t tp, int sid);
+		void Clear();
+};
+
+#endif /* __zapit_psicache_h__ */
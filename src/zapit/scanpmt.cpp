@@ -26,6 +26,7 @@
 #include "debug.h"
 #include "scanpmt.h"
 #include "scan.h"
+#include "psicache.h"
 #include <eitd/edvbstring.h>
 #include <hardware/dmx.h>
 
@@ -57,12 +58,16 @@ CPmt::~CPmt()
 {
 }
 
-bool CPmt::Read(unsigned short pid, unsigned short sid)
+/* tp != 0: use the transponder PSI cache, timeout 0: demux default */
+bool CPmt::Read(unsigned short pid, unsigned short sid, transponder_id_t tp, int timeout)
 {
 	bool ret = true;
 	unsigned char filter[DMX_FILTER_SIZE];
 	unsigned char mask[DMX_FILTER_SIZE];
 
+	if (tp && CPsiCache::getInstance()->GetPmt(tp, pid, sid, buffer, PMT_SECTION_SIZE))
+		return true;
+
 	cDemux * dmx = new cDemux(dmxnum);
 	dmx->Open(DMX_PSI_CHANNEL);
 
@@ -79,22 +84,28 @@ bool CPmt::Read(unsigned short pid, unsigned short sid)
 	mask[2] = 0xFF;
 	mask[3] = 0x01;
 	mask[4] = 0xFF;
-	if ((!dmx->sectionFilter(pid, filter, mask, 5)) || (dmx->Read(buffer, PMT_SECTION_SIZE) < 0)) {
+	if ((!dmx->sectionFilter(pid, filter, mask, 5)) || (dmx->Read(buffer, PMT_SECTION_SIZE, timeout) < 0)) {
 		printf("CPmt::Read: pid %x failed\n", pid);
 		ret = false;
 	}
 	delete dmx;
+	if (tp) {
+		if (ret)
+			CPsiCache::getInstance()->PutPmt(tp, pid, sid, buffer);
+		else
+			CPsiCache::getInstance()->Abort(tp, sid);
+	}
 	return ret;
 }
 
-bool CPmt::Parse(CZapitChannel * const channel)
+bool CPmt::Parse(CZapitChannel * const channel, int timeout)
 {
 	printf("[zapit] parsing pmt pid 0x%X (%s)\n", channel->getPmtPid(), channel->getName().c_str());
 
 	if (channel->getPmtPid() == 0)
 		return false;
 
-	if(!Read(channel->getPmtPid(), channel->getServiceId()))
+	if(!Read(channel->getPmtPid(), channel->getServiceId(), channel->getTransponderId(), timeout))
 		return false;
 
 	ProgramMapSection pmt(buffer);
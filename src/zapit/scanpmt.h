@@ -28,13 +28,16 @@ int pmt_set_update_filter(CZapitChannel * const channel, int * fd);
 int pmt_stop_update_filter(int * fd);
 
 #define PMT_SECTION_SIZE 1024
+/* ms to wait for a PMT on a pid that may be stale, TR 101 290 wants
+   one at least every 500ms */
+#define PMT_PROBE_TIMEOUT 600
 class CPmt
 {
 	private:
 		int dmxnum;
 		unsigned char buffer[PMT_SECTION_SIZE];
 
-		bool Read(unsigned short pid, unsigned short sid);
+		bool Read(unsigned short pid, unsigned short sid, transponder_id_t tp = 0, int timeout = 0);
 		void MakeCAMap(casys_map_t &camap);
 		void MakeCAPids(casys_map_t &capids);
 		bool ParseEsInfo(ElementaryStreamInfo *esinfo, CZapitChannel * const channel);
@@ -42,7 +45,7 @@ class CPmt
 		CPmt(int dnum = 0);
 		~CPmt();
 
-		bool Parse(CZapitChannel * const channel);
+		bool Parse(CZapitChannel * const channel, int timeout = 0);
 		bool haveCaSys(int pmtpid, int service_id);
 };
 
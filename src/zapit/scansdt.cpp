@@ -48,6 +48,7 @@ CSdt::CSdt(t_satellite_position spos, freq_id_t frq, bool curr, int dnum)
 	current = curr;
 	transport_stream_id = 0;
 	original_network_id = 0;
+	version = -1;
 	//FIXME sdt update ??
 	cable = CFEManager::getInstance()->getLiveFE()->getCurrentDeliverySystem() == DVB_C;
 }
@@ -174,6 +175,8 @@ _repeat:
 		}
 		secdone[secnum] = 1;
 		sectotal++;
+		if (version < 0)
+			version = (buffer[5] >> 1) & 0x1F;
 
 		ServiceDescriptionSection * sdt = new ServiceDescriptionSection(buffer);
 		sections.push_back(sdt);
@@ -191,6 +194,42 @@ _repeat:
 	return true;
 }
 
+int CSdt::ReadVersion(t_transport_stream_id tsid, t_original_network_id onid)
+{
+	unsigned char buffer[SDT_SECTION_SIZE];
+	unsigned char filter[DMX_FILTER_SIZE];
+	unsigned char mask[DMX_FILTER_SIZE];
+	int ret = -1;
+
+	cDemux * dmx = new cDemux(dmxnum);
+	dmx->Open(DMX_PSI_CHANNEL);
+
+	memset(filter, 0x00, DMX_FILTER_SIZE);
+	memset(mask, 0x00, DMX_FILTER_SIZE);
+
+	filter[0] = 0x42;
+	filter[1] = (tsid >> 8) & 0xff;
+	filter[2] = tsid & 0xff;
+	filter[3] = 0x01;	/* current_next_indicator */
+	filter[4] = 0x00;	/* section_number */
+	filter[6] = (onid >> 8) & 0xff;
+	filter[7] = onid & 0xff;
+
+	mask[0] = 0xFF;
+	mask[1] = 0xFF;
+	mask[2] = 0xFF;
+	mask[3] = 0x01;
+	mask[4] = 0xFF;
+	mask[6] = 0xFF;
+	mask[7] = 0xFF;
+
+	if (dmx->sectionFilter(0x11, filter, mask, 8) && (dmx->Read(buffer, SDT_SECTION_SIZE) > 0))
+		ret = (buffer[5] >> 1) & 0x1F;
+
+	delete dmx;
+	return ret;
+}
+
 /* parse sdt sections */
 bool CSdt::Parse(t_transport_stream_id &tsid, t_original_network_id &onid)
 {
@@ -41,6 +41,7 @@ class CSdt
 		t_satellite_position satellitePosition;
 		freq_id_t freq_id;
 		std::string lastProviderName;
+		int version;
 
 		ServiceDescriptionSectionList sections;
 		CPat pat;
@@ -64,6 +65,10 @@ class CSdt
 		CSdt(t_satellite_position spos, freq_id_t frq, bool curr = false, int dnum = 0);
 		~CSdt();
 		bool Parse(t_transport_stream_id &tsid, t_original_network_id &onid);
+		/* version of sdt sections read by Parse, -1 if none */
+		int GetVersion() { return version; }
+		/* read only the first section of actual sdt, return its version or -1 */
+		int ReadVersion(t_transport_stream_id tsid, t_original_network_id onid);
 };
 
 #endif
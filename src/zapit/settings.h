@@ -34,6 +34,7 @@
 #define ZAPITCONFIGFILE      ZAPITDIR "/zapit.conf"
 #define SERVICES_XML    ZAPITDIR "/services.xml"
 #define SERVICES_TMP    "/tmp/services.tmp"
+#define SERVICES_BIN    ZAPITDIR "/services.bin"
 #define BOUQUETS_XML    ZAPITDIR "/bouquets.xml"
 #define UBOUQUETS_XML    ZAPITDIR "/ubouquets.xml"
 #define BOUQUETS_TMP    "/tmp/bouquets.tmp"
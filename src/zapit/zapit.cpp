@@ -44,6 +44,7 @@
 #include "debug.h"
 #include "getservices.h"
 #include "pat.h"
+#include "psicache.h"
 #include "scanpmt.h"
 #include "scan.h"
 //#include "fastscan.h"
@@ -137,6 +138,7 @@ CZapit::CZapit()
 	standby = true;
 	event_mode = true;
 	firstzap = true;
+	memset(&zap_times, 0, sizeof(zap_times));
 	playing = false;
 	list_changed = false; // flag to indicate, allchans was changed
 	currentMode = 0;
@@ -488,7 +490,7 @@ bool CZapit::TuneChannel(CFrontend * frontend, CZapitChannel * channel, bool &tr
 	return true;
 }
 
-bool CZapit::ParsePatPmt(CZapitChannel * channel)
+bool CZapit::ParsePatPmt(CZapitChannel * channel, CZapitClient::responseZapTimes *times)
 {
 	if(channel == NULL)
 		return false;
@@ -497,24 +499,81 @@ bool CZapit::ParsePatPmt(CZapitChannel * channel)
 	CPmt pmt(channel->getRecordDemux());
 	DBG("looking up pids for channel_id " PRINTF_CHANNEL_ID_TYPE "\n", channel->getChannelID());
 
+	int64_t start = time_monotonic_ms();
+	/* pmt pid known from services.xml or last zap: the section filter
+	   checks the service id, so try it before waiting for the PAT.
+	   the pid may have moved, so don't wait the full demux timeout */
+	if (channel->getPmtPid()) {
+		if (pmt.Parse(channel, PMT_PROBE_TIMEOUT)) {
+			if (times) {
+				times->pat_ms = 0;
+				times->pmt_ms = time_monotonic_ms() - start;
+			}
+			return true;
+		}
+		channel->setPmtPid(0);
+	}
+
 	if(!pat.Parse(channel)) {
 		printf("[zapit] pat parsing failed\n");
 		return false;
 	}
+	int64_t pat_done = time_monotonic_ms();
 	if (!pmt.Parse(channel)) {
 		printf("[zapit] pmt parsing failed\n");
+		/* the cached PAT may be outdated, read it again next time */
+		CPsiCache::getInstance()->Invalidate(channel->getTransponderId(), PSI_CACHE_PAT);
 		return false;
 	}
+	if (times) {
+		times->pat_ms = pat_done - start;
+		times->pmt_ms = time_monotonic_ms() - pat_done;
+	}
 	return true;
 }
 
+/* start decoders with the pids from the last zap, PAT/PMT are checked afterwards */
+bool CZapit::FastZapStart(CZapitChannel * channel)
+{
+	fastzap_map_t::iterator it = fastzap_map.find(channel->getChannelID());
+	if (it == fastzap_map.end())
+		return false;
+
+	fastzap_pids_t &fz = it->second;
+	channel->resetPids();
+	channel->setVideoPid(fz.vpid);
+	channel->setPcrPid(fz.pcrpid);
+	channel->setTeletextPid(fz.ttxpid);
+	channel->type = fz.vtype;
+	if (fz.apid)
+		channel->addAudioChannel(fz.apid, fz.atype, "", 0xFF);
+
+	INFO("[zapit] fast zap vpid %x apid %x pcr %x", fz.vpid, fz.apid, fz.pcrpid);
+	return StartPlayBack(channel);
+}
+
+void CZapit::FastZapSave(CZapitChannel * channel)
+{
+	fastzap_pids_t fz;
+	fz.vpid = channel->getVideoPid();
+	fz.apid = channel->getAudioPid();
+	fz.pcrpid = channel->getPcrPid();
+	fz.ttxpid = channel->getTeletextPid();
+	fz.vtype = channel->type;
+	fz.atype = channel->getAudioChannel() ? channel->getAudioChannel()->audioChannelType : CZapitAudioChannel::MPEG;
+	fastzap_map[channel->getChannelID()] = fz;
+}
+
 bool CZapit::ZapIt(const t_channel_id channel_id, bool forupdate, bool startplayback)
 {
 	bool transponder_change = false;
 	bool failed = false;
+	bool fastzap = false;
 	CZapitChannel* newchannel;
 
 	abort_zapit = 0;
+	int64_t zap_start = time_monotonic_ms();
+	memset(&zap_times, 0, sizeof(zap_times));
 	if((newchannel = CServiceManager::getInstance()->FindChannel(channel_id, &current_is_nvod)) == NULL) {
 		INFO("channel_id " PRINTF_CHANNEL_ID_TYPE " not found", channel_id);
 		return false;
@@ -608,10 +667,12 @@ bool CZapit::ZapIt(const t_channel_id channel_id, bool forupdate, bool startplay
 		 * pretty sure rand() is not much worse :-) */
 		usleep(rand_us);
 		live_fe->tuned = false;
+		CPsiCache::getInstance()->Invalidate(current_channel->getTransponderId(), PSI_CACHE_PAT);
 		retry--;
 		goto again;
 	}
 	SendEvent(CZapitClient::EVT_TUNE_COMPLETE, &live_channel_id, sizeof(t_channel_id));
+	zap_times.tune_ms = time_monotonic_ms() - zap_start;
 
 #if ENABLE_PIP
 	if (transponder_change && (live_fe == pip_fe[0]))
@@ -628,13 +689,26 @@ bool CZapit::ZapIt(const t_channel_id channel_id, bool forupdate, bool startplay
 		return true;
 	}
 
-	failed = !ParsePatPmt(current_channel);
+	/* scrambled channels need the CA PMT first, so only free ones are started early */
+	if (startplayback && !fastzap && !current_channel->scrambled) {
+		fastzap = FastZapStart(current_channel);
+		if (fastzap)
+			zap_times.start_ms = time_monotonic_ms() - zap_start;
+	}
+	zap_times.fastzap = fastzap;
+
+	failed = !ParsePatPmt(current_channel, &zap_times);
 
 	if (failed && retry > 0) {
 		int rand_us = (rand() * 1000000LL / RAND_MAX);
 		printf("[zapit] %s:2 SCR retry tuning %d after %dms\n", __func__, retry, rand_us / 1000);
+		if (fastzap) {
+			StopPlayBack(false);
+			fastzap = false;
+		}
 		usleep(rand_us);
 		live_fe->tuned = false;
+		CPsiCache::getInstance()->Invalidate(current_channel->getTransponderId(), PSI_CACHE_PAT);
 		retry--;
 		goto again;
 	}
@@ -649,15 +723,36 @@ bool CZapit::ZapIt(const t_channel_id channel_id, bool forupdate, bool startplay
 	if (transponder_change)
 		SdtMonitor.Wakeup();
 
-	if (failed)
+	if (failed) {
+		if (fastzap) {
+			StopPlayBack(false);
+			fastzap_map.erase(live_channel_id);
+		}
 		return false;
+	}
 
 	//current_channel->getCaPmt()->ca_pmt_list_management = transponder_change ? 0x03 : 0x04;
 
 	RestoreChannelPids(current_channel);
 
-	if (startplayback /* && !we_playing*/)
+	if (fastzap) {
+		/* restart only if the PMT does not match the pids we started with */
+		fastzap_pids_t &fz = fastzap_map[live_channel_id];
+		if (fz.vpid != current_channel->getVideoPid() || fz.apid != current_channel->getAudioPid()
+				|| fz.pcrpid != current_channel->getPcrPid() || fz.vtype != current_channel->type
+				|| fz.ttxpid != current_channel->getTeletextPid()) {
+			INFO("[zapit] fast zap pids changed, restarting playback");
+			StopPlayBack(false);
+			StartPlayBack(current_channel);
+			zap_times.start_ms = time_monotonic_ms() - zap_start;
+		}
+	} else if (startplayback /* && !we_playing*/) {
 		StartPlayBack(current_channel);
+		zap_times.start_ms = time_monotonic_ms() - zap_start;
+	}
+	FastZapSave(current_channel);
+	INFO("[zapit] zap times: tune %u pat %u pmt %u start %u ms%s", zap_times.tune_ms, zap_times.pat_ms,
+			zap_times.pmt_ms, zap_times.start_ms, fastzap ? " (fast zap)" : "");
 
 	//printf("[zapit] sending capmt....\n");
 
@@ -1252,6 +1347,7 @@ void CZapit::SetRecordMode(bool enable)
 bool CZapit::PrepareChannels()
 {
 	current_channel = 0;
+	CPsiCache::getInstance()->Clear();
 
 	g_bouquetManager->empty = true;
 	if (!CServiceManager::getInstance()->LoadServices(false)){
@@ -2076,6 +2172,11 @@ bool CZapit::ParseCommand(CBasicMessage::Header &rmsg, int connfd)
 		break;
 	}
 
+	case CZapitMessages::CMD_GET_ZAP_TIMES: {
+		CBasicServer::send_data(connfd, &zap_times, sizeof(zap_times));
+		break;
+	}
+
 	case CZapitMessages::CMD_GET_VIDEO_FORMAT: {
 		CZapitMessages::commandInt msg;
 		msg.val = CNeutrinoApp::getInstance()->getVideoFormat();
@@ -2913,6 +3014,7 @@ void CZapit::run()
 					int vpid = current_channel->getVideoPid();
 					int apid = current_channel->getAudioPid();
 					CPmt pmt;
+					CPsiCache::getInstance()->Invalidate(current_channel->getTransponderId(), current_channel->getServiceId());
 					pmt.Parse(current_channel);
 					bool apid_found = false;
 					/* check if selected audio pid still present */
@@ -3055,20 +3157,36 @@ void CZapit::GetConfig(Zapit_config &Cfg)
 	Cfg = config;
 }
 
+/* delay after transponder change before sdt is read */
+#define SDT_WAKEUP_DELAY	2
+/* interval to check sdt version of current transponder */
+#define SDT_CHECK_INTERVAL	300
+
 CZapitSdtMonitor::CZapitSdtMonitor()
 {
 	sdt_wakeup = false;
 	started = false;
+	pthread_mutex_init(&mutex, NULL);
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&cond, &attr);
+	pthread_condattr_destroy(&attr);
 }
 
 CZapitSdtMonitor::~CZapitSdtMonitor()
 {
 	Stop();
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&mutex);
 }
 
 void CZapitSdtMonitor::Wakeup()
 {
+	pthread_mutex_lock(&mutex);
 	sdt_wakeup = true;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
 }
 
 bool CZapitSdtMonitor::Start()
@@ -3082,14 +3200,81 @@ bool CZapitSdtMonitor::Stop()
 {
 	if (!started)
 		return false;
+	pthread_mutex_lock(&mutex);
 	started = false;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
 	int ret = join();
 	return (ret == 0);
 }
 
+/* check sdt of transponder, update services if sdt version changed.
+ * return time for next check, or 0 if transponder should not be checked again */
+time_t CZapitSdtMonitor::Check(transponder_id_t tpid, t_transport_stream_id transport_stream_id, t_original_network_id original_network_id,
+		t_satellite_position satellitePosition, freq_id_t freq)
+{
+	time_t next = time_monotonic() + SDT_CHECK_INTERVAL;
+
+	if(!CZapit::getInstance()->GetScanSDT())
+		return next;
+
+	printf("[sdt monitor] wakeup...\n");
+
+	if(CServiceScan::getInstance()->Scanning() || CZapit::getInstance()->Recording())
+		return next;
+
+	transponder_list_t::iterator tI = transponders.find(tpid);
+	if(tI == transponders.end()) {
+		printf("[sdt monitor] tp not found ?!\n");
+		return 0;
+	}
+
+	sdt_tp_map_t::iterator stI = sdt_tp.find(tpid);
+	if ((stI != sdt_tp.end()) && (stI->second.version >= 0)) {
+		CSdt sdt(satellitePosition, freq, true);
+		int version = sdt.ReadVersion(transport_stream_id, original_network_id);
+		if (version < 0) {
+			/* read timeout or other transponder: nothing known, try again later */
+			printf("[sdt monitor] sdt version read failed, keeping %d\n", stI->second.version);
+			return next;
+		}
+		if (version == stI->second.version) {
+			printf("[sdt monitor] sdt version %d unchanged.\n", version);
+			return next;
+		}
+		printf("[sdt monitor] sdt version %d -> %d\n", stI->second.version, version);
+	}
+
+	CServiceManager::getInstance()->RemoveCurrentChannels();
+
+	CSdt sdt(satellitePosition, freq, true);
+	if(!sdt.Parse(transport_stream_id, original_network_id))
+		return next;
+
+	sdt_tp_info_t &info = sdt_tp[tpid];
+	info.version = sdt.GetVersion();
+	info.updated = time_monotonic();
+
+	bool updated = CServiceManager::getInstance()->SaveCurrentServices(tpid);
+	CServiceManager::getInstance()->CopyCurrentServices(tpid);
+
+	if(updated && (CZapit::getInstance()->GetScanSDT()))
+		CZapit::getInstance()->SendEvent(CZapitClient::EVT_SDT_CHANGED);
+	if(!updated)
+		printf("[sdt monitor] no changes.\n");
+	else
+		printf("[sdt monitor] found changes.\n");
+#if HAVE_ARM_HARDWARE || HAVE_MIPS_HARDWARE
+	//now it's time to continue the CA pollthread
+	if (!ca->getZapitReady())
+		ca->setZapitReady();
+#endif
+	return next;
+}
+
 void CZapitSdtMonitor::run()
 {
-	time_t /*tstart,*/ tcur = 0, wtime = 0;
+	time_t due = 0;
 	t_transport_stream_id transport_stream_id = 0;
 	t_original_network_id original_network_id = 0;
 	t_satellite_position satellitePosition = 0;
@@ -3097,77 +3282,46 @@ void CZapitSdtMonitor::run()
 	transponder_id_t tpid = 0;
 	set_threadname("zap:sdtmonitor");
 
-	//tstart = time(0);
 	sdt_tp.clear();
 	printf("[zapit] sdt monitor started\n");
+	pthread_mutex_lock(&mutex);
 	while(started) {
-		sleep(1);
+		if (!sdt_wakeup) {
+			if (due) {
+				time_t wait = due - time_monotonic();
+				if (wait > 0) {
+					struct timespec abs;
+					clock_gettime(CLOCK_MONOTONIC, &abs);
+					abs.tv_sec += wait;
+					pthread_cond_timedwait(&cond, &mutex, &abs);
+				}
+			} else
+				pthread_cond_wait(&cond, &mutex);
+		}
+		if (!started)
+			break;
+
 		if(sdt_wakeup) {
-			sdt_wakeup = 0;
+			/* transponder changed, check after zap settled */
+			sdt_wakeup = false;
 			CZapitChannel * channel = CZapit::getInstance()->GetCurrentChannel();
 			if(channel) {
-				wtime = time(0);
+				due = time_monotonic() + SDT_WAKEUP_DELAY;
 				transport_stream_id = channel->getTransportStreamId();
 				original_network_id = channel->getOriginalNetworkId();
 				satellitePosition = channel->getSatellitePosition();
 				freq = channel->getFreqId();
 				tpid = channel->getTransponderId();
 			}
+			continue;
 		}
-		if(!CZapit::getInstance()->GetScanSDT())
+		if (!due || (time_monotonic() < due))
 			continue;
 
-		tcur = time(0);
-		if(wtime && ((tcur - wtime) > 2) && !sdt_wakeup) {
-			printf("[sdt monitor] wakeup...\n");
-			wtime = 0;
-
-			if(CServiceScan::getInstance()->Scanning() || CZapit::getInstance()->Recording())
-				continue;
-
-			transponder_list_t::iterator tI = transponders.find(tpid);
-			if(tI == transponders.end()) {
-				printf("[sdt monitor] tp not found ?!\n");
-				continue;
-			}
-			sdt_tp_map_t::iterator stI = sdt_tp.find(tpid);
-
-			if ((stI != sdt_tp.end()) && ((time_monotonic() - stI->second) < 3600)) {
-				printf("[sdt monitor] TP already updated less than an hour ago.\n");
-				continue;
-			}
-
-			CServiceManager::getInstance()->RemoveCurrentChannels();
-
-#if 0
-			int ret = parse_current_sdt(transport_stream_id, original_network_id, satellitePosition, freq);
-			if(ret) {
-				if(ret == -1)
-					printf("[sdt monitor] scanSDT broken ?\n");
-				continue;
-			}
-#endif
-			CSdt sdt(satellitePosition, freq, true);
-			if(!sdt.Parse(transport_stream_id, original_network_id)) {
-				continue;
-			}
-			sdt_tp.insert(std::pair <transponder_id_t, time_t> (tpid, time_monotonic()));
-
-			bool updated = CServiceManager::getInstance()->SaveCurrentServices(tpid);
-			CServiceManager::getInstance()->CopyCurrentServices(tpid);
-
-			if(updated && (CZapit::getInstance()->GetScanSDT()))
-				CZapit::getInstance()->SendEvent(CZapitClient::EVT_SDT_CHANGED);
-			if(!updated)
-				printf("[sdt monitor] no changes.\n");
-			else
-				printf("[sdt monitor] found changes.\n");
-#if HAVE_ARM_HARDWARE || HAVE_MIPS_HARDWARE
-			//now it's time to continue the CA pollthread
-			if (!ca->getZapitReady())
-				ca->setZapitReady();
-#endif
-		}
+		pthread_mutex_unlock(&mutex);
+		due = Check(tpid, transport_stream_id, original_network_id, satellitePosition, freq);
+		pthread_mutex_lock(&mutex);
 	}
+	pthread_mutex_unlock(&mutex);
 	return;
 }
@@ -5,6 +5,7 @@
 #ifndef __zapit_h__
 #define __zapit_h__
 
+#include <pthread.h>
 #include <OpenThreads/Thread>
 #include <OpenThreads/ReentrantMutex>
 #include <configfile.h>
@@ -30,7 +31,24 @@
 
 typedef std::map<t_channel_id, audio_map_set_t> audio_map_t;
 typedef audio_map_t::iterator audio_map_iterator_t;
-typedef std::map<transponder_id_t, time_t> sdt_tp_map_t;
+typedef struct sdt_tp_info {
+	int version;		/* sdt version of last parse */
+	time_t updated;		/* time of last parse */
+} sdt_tp_info_t;
+typedef std::map<transponder_id_t, sdt_tp_info_t> sdt_tp_map_t;
+
+/* pids used on the last zap to a channel, to start the decoders
+   before PAT and PMT are read again */
+typedef struct fastzap_pids
+{
+	unsigned short vpid;
+	unsigned short apid;
+	unsigned short pcrpid;
+	unsigned short ttxpid;
+	unsigned char vtype;
+	CZapitAudioChannel::ZapitAudioChannelType atype;
+} fastzap_pids_t;
+typedef std::map<t_channel_id, fastzap_pids_t> fastzap_map_t;
 
 typedef std::pair<int, int> pid_pair_t;
 typedef std::pair<t_channel_id, pid_pair_t> volume_pair_t;
@@ -90,10 +108,14 @@ class CZapitSdtMonitor : public OpenThreads::Thread
 	private:
 		bool started;
 		bool sdt_wakeup;
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
 
 		sdt_tp_map_t sdt_tp;
 
 		void run();
+		time_t Check(transponder_id_t tpid, t_transport_stream_id tsid, t_original_network_id onid,
+				t_satellite_position satellitePosition, freq_id_t freq);
 
 	public:
 		CZapitSdtMonitor();
@@ -162,6 +184,8 @@ class CZapit : public OpenThreads::Thread
 #endif
 
 		audio_map_t audio_map;
+		fastzap_map_t fastzap_map;
+		CZapitClient::responseZapTimes zap_times;
 		volume_map_t vol_map;
 		OpenThreads::Mutex vol_map_mutex;
 		int volume_percent_ac3;
@@ -184,7 +208,9 @@ class CZapit : public OpenThreads::Thread
 		//void ConfigFrontend();
 
 		bool TuneChannel(CFrontend *frontend, CZapitChannel * channel, bool &transponder_change, bool send_event = true);
-		bool ParsePatPmt(CZapitChannel * channel);
+		bool ParsePatPmt(CZapitChannel * channel, CZapitClient::responseZapTimes *times = NULL);
+		bool FastZapStart(CZapitChannel * channel);
+		void FastZapSave(CZapitChannel * channel);
 
 		bool send_data_count(int connfd, int data_count);
 		void sendAPIDs(int connfd);